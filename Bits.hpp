@@ -1,5 +1,6 @@
 #pragma once
 
+#include <bit>
 #include <cstdint>
 #include <array>
 
@@ -141,3 +142,102 @@ constexpr uint64_t convolve_uint64_t(uint64_t x, uint64_t y) {
   }
   return result;
 }
+
+// Software PEXT and PDEP, from Hacker's Delight. `compress_right` packs
+// the bits of x selected by m into the low bits, `expand_right` undoes it.
+constexpr uint64_t compress_right(uint64_t x, uint64_t m) {
+  x = x & m;           // Clear irrelevant bits.
+  uint64_t mk = ~m << 1; // We will count 0's to right.
+
+  for (int i = 0; i < 6; i++) {
+    uint64_t mp = mk ^ (mk << 1); // Parallel prefix.
+    mp = mp ^ (mp << 2);
+    mp = mp ^ (mp << 4);
+    mp = mp ^ (mp << 8);
+    mp = mp ^ (mp << 16);
+    mp = mp ^ (mp << 32);
+    uint64_t mv = mp & m;              // Bits to move.
+    m = (m ^ mv) | (mv >> (1 << i));   // Compress m.
+    uint64_t t = x & mv;
+    x = (x ^ t) | (t >> (1 << i));     // Compress x.
+    mk = mk & ~mp;
+  }
+  return x;
+}
+
+constexpr uint64_t expand_right(uint64_t x, uint64_t m) {
+  uint64_t m0 = m;
+  uint64_t mk = ~m << 1;
+  uint64_t moves[6];
+
+  for (int i = 0; i < 6; i++) {
+    uint64_t mp = mk ^ (mk << 1);
+    mp = mp ^ (mp << 2);
+    mp = mp ^ (mp << 4);
+    mp = mp ^ (mp << 8);
+    mp = mp ^ (mp << 16);
+    mp = mp ^ (mp << 32);
+    uint64_t mv = mp & m;
+    moves[i] = mv;
+    m = (m ^ mv) | (mv >> (1 << i));
+    mk = mk & ~mp;
+  }
+
+  for (int i = 5; i >= 0; i--) {
+    uint64_t mv = moves[i];
+    uint64_t t = x << (1 << i);
+    x = (x & ~mv) | (t & mv);
+  }
+  return x & m0;
+}
+
+// The same over a whole array, with PEXT/PDEP when the CPU has them and
+// they are fast. The check is made once per call, not per word.
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+
+// PEXT and PDEP are microcoded on AMD before Zen 3, taking hundreds of
+// cycles, so those get the software version too
+inline bool has_fast_bmi2() {
+  static const bool result = __builtin_cpu_supports("bmi2") &&
+                             !__builtin_cpu_is("znver1") &&
+                             !__builtin_cpu_is("znver2");
+  return result;
+}
+
+__attribute__((target("bmi2"))) inline void
+compress_right_bmi2(const uint64_t *x, uint64_t *out, unsigned n, uint64_t m) {
+  for (unsigned i = 0; i < n; i++)
+    out[i] = _pext_u64(x[i], m);
+}
+
+__attribute__((target("bmi2"))) inline void
+expand_right_bmi2(const uint64_t *x, uint64_t *out, unsigned n, uint64_t m) {
+  for (unsigned i = 0; i < n; i++)
+    out[i] = _pdep_u64(x[i], m);
+}
+#else
+inline bool has_fast_bmi2() { return false; }
+#endif
+
+inline void compress_right(const uint64_t *x, uint64_t *out, unsigned n, uint64_t m) {
+#if defined(__x86_64__) && defined(__GNUC__)
+  if (has_fast_bmi2()) {
+    compress_right_bmi2(x, out, n, m);
+    return;
+  }
+#endif
+  for (unsigned i = 0; i < n; i++)
+    out[i] = compress_right(x[i], m);
+}
+
+inline void expand_right(const uint64_t *x, uint64_t *out, unsigned n, uint64_t m) {
+#if defined(__x86_64__) && defined(__GNUC__)
+  if (has_fast_bmi2()) {
+    expand_right_bmi2(x, out, n, m);
+    return;
+  }
+#endif
+  for (unsigned i = 0; i < n; i++)
+    out[i] = expand_right(x[i], m);
+}
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <unordered_set>
+
+#include "LifeAPI.hpp"
+#include "LifeHistory.hpp"
+#include "LifeTarget.hpp"
+#include "LifeWeld.hpp"
+#include "Symmetry.hpp"
+#include "Threads.hpp"
+
+// Tries every catalyst of a library, in every distinct orientation, at
+// every offset where it could touch a reaction, and reports the
+// placements where the catalyst is disturbed and then recovers.
+
+struct Catalyst {
+  std::string name;
+  LifeWeld weld;
+  unsigned maxRecovery; // Generations it may stay disturbed
+
+  // Like `SymmetryOrbitRepresentatives`, but the frozen counts have to
+  // match as well
+  std::vector<SymmetryTransform> Orientations() const {
+    std::vector<LifeWeld> seen;
+    std::vector<SymmetryTransform> transforms;
+    for (auto t : allTransforms) {
+      LifeWeld transformed = weld.Transformed(t);
+      auto bounds = (transformed.state | transformed.AllFrozen()).XYBounds();
+      transformed = transformed.Moved({-bounds[0], -bounds[1]});
+      if (std::find(seen.begin(), seen.end(), transformed) == seen.end()) {
+        seen.push_back(transformed);
+        transforms.push_back(t);
+      }
+    }
+    return transforms;
+  }
+};
+
+// One catalyst per line: `name maxRecovery rle`, where the RLE is in
+// LifeHistory format. Live cells are the catalyst and marked cells are
+// required to stay unchanged (so C is a required live cell, D a required
+// dead cell). Blank lines and lines starting with # are ignored.
+inline std::vector<Catalyst> ParseCatalystLibrary(const std::string &text) {
+  std::vector<Catalyst> result;
+
+  std::istringstream lines(text);
+  std::string line;
+  while (std::getline(lines, line)) {
+    std::istringstream fields(line);
+    std::string name, rle;
+    unsigned maxRecovery;
+    if (!(fields >> name) || name[0] == '#')
+      continue;
+    if (!(fields >> maxRecovery >> rle))
+      continue;
+
+    LifeHistory pattern = LifeHistory::Parse(rle);
+    result.push_back({name, LifeWeld::FromRequired(pattern.state, pattern.marked), maxRecovery});
+  }
+
+  return result;
+}
+
+struct CatalystPlacement {
+  unsigned catalyst;
+  SymmetryTransform transform;
+  std::pair<int, int> offset;
+
+  auto operator<=>(const CatalystPlacement &) const = default;
+};
+
+struct CatalystSolution {
+  CatalystPlacement placement;
+  LifeState start;         // Reaction and catalyst together
+  unsigned interaction;    // First generation the reaction is changed
+  unsigned recovery;       // First generation it is back for good
+  uint64_t hash;           // GetOctoHash just before the interaction
+};
+
+struct CatalystSearchParams {
+  unsigned maxGeneration = 100;  // How long the reaction is followed
+  unsigned recoveredFor = 4;     // Generations the catalyst must stay intact
+  unsigned threads = 0;          // 0 for one per core
+  unsigned batchSize = 64;       // Candidates taken by a thread at once
+};
+
+struct CatalystSearchStats {
+  uint64_t candidates = 0;
+  uint64_t solutions = 0;
+  double seconds = 0;
+
+  double CandidatesPerSecond() const {
+    return seconds > 0 ? candidates / seconds : 0;
+  }
+};
+
+class CatalystSearch {
+public:
+  CatalystSearch(const LifeState &reaction, const std::vector<Catalyst> &library,
+                 const CatalystSearchParams &params = CatalystSearchParams())
+      : reaction{reaction}, library{library}, params{params} {
+    LifeState current = reaction;
+    for (unsigned i = 0; i <= params.maxGeneration; i++) {
+      generations.push_back(current);
+      envelope |= current;
+      current.Step();
+    }
+  }
+
+  std::vector<CatalystSolution> Run(CatalystSearchStats *stats = nullptr) const;
+
+  // Offsets for one orientation of a catalyst that aren't ruled out
+  // before simulating
+  LifeState CandidateOffsets(const LifeWeld &catalyst) const;
+
+  std::optional<CatalystSolution> Test(const CatalystPlacement &placement) const;
+
+private:
+  LifeState reaction;
+  std::vector<Catalyst> library;
+  CatalystSearchParams params;
+
+  // The reaction without any catalyst
+  std::vector<LifeState> generations;
+  LifeState envelope;
+};
+
+inline LifeState CatalystSearch::CandidateOffsets(const LifeWeld &catalyst) const {
+  // Anything further away can never be touched by the reaction
+  LifeState reachable = envelope.ZOI().Convolve(catalyst.state.ZOI().Mirrored());
+
+  // Placements that overlap or already interact at generation 0
+  LifeState immediate = LifeWeld(reaction).InteractionOffsets(catalyst);
+
+  return reachable & ~immediate;
+}
+
+inline std::optional<CatalystSolution>
+CatalystSearch::Test(const CatalystPlacement &placement) const {
+  const Catalyst &catalyst = library[placement.catalyst];
+  LifeWeld placed = catalyst.weld.Transformed(placement.transform).Moved(placement.offset);
+  LifeTarget target = placed.ToTarget();
+
+  LifeWeld current = placed;
+  current.state |= reaction;
+  LifeState start = current.state;
+
+  unsigned interaction = 0;
+  unsigned recovery = 0;
+  LifeState collision;
+
+  for (unsigned gen = 1; gen <= params.maxGeneration; gen++) {
+    LifeState previous = current.state;
+    current.Step();
+
+    if (interaction == 0) {
+      // Nothing has happened until the reaction goes differently
+      if (current.state != (generations[gen] | placed.state)) {
+        // Already touching, which `InteractionOffsets` can't see next to
+        // frozen cells
+        if (gen == 1)
+          return std::nullopt;
+        interaction = gen;
+        collision = previous;
+      }
+      continue;
+    }
+
+    bool intact = current.state.Contains(target);
+
+    if (intact) {
+      if (recovery == 0)
+        recovery = gen;
+      if (gen - recovery + 1 >= params.recoveredFor)
+        return CatalystSolution{placement, start, interaction, recovery, collision.GetOctoHash()};
+    } else {
+      recovery = 0;
+      if (gen - interaction > catalyst.maxRecovery)
+        return std::nullopt;
+    }
+  }
+
+  return std::nullopt;
+}
+
+inline std::vector<CatalystSolution> CatalystSearch::Run(CatalystSearchStats *stats) const {
+  auto startTime = std::chrono::steady_clock::now();
+
+  std::vector<CatalystPlacement> candidates;
+  for (unsigned i = 0; i < library.size(); i++) {
+    for (auto t : library[i].Orientations()) {
+      LifeState offsets = CandidateOffsets(library[i].weld.Transformed(t));
+      for (auto offset : offsets.Cells())
+        candidates.push_back({i, t, offset});
+    }
+  }
+
+  std::vector<CatalystSolution> solutions;
+  std::mutex solutionsMutex;
+  std::atomic<size_t> next = 0;
+
+  auto worker = [&]() {
+    while (true) {
+      size_t begin = next.fetch_add(params.batchSize);
+      if (begin >= candidates.size())
+        break;
+      size_t end = std::min(begin + params.batchSize, candidates.size());
+
+      std::vector<CatalystSolution> found;
+      for (size_t i = begin; i < end; i++) {
+        auto solution = Test(candidates[i]);
+        if (solution)
+          found.push_back(*solution);
+      }
+
+      std::lock_guard<std::mutex> lock(solutionsMutex);
+      solutions.insert(solutions.end(), found.begin(), found.end());
+    }
+  };
+
+  RunWorkers(params.threads, worker);
+
+  // The threads finish in any order, so sort before deduping to keep
+  // the same representative of equivalent placements every time
+  std::sort(solutions.begin(), solutions.end(),
+            [](const CatalystSolution &a, const CatalystSolution &b) {
+              return a.placement < b.placement;
+            });
+
+  std::unordered_set<uint64_t> seen;
+  std::erase_if(solutions, [&](const CatalystSolution &solution) {
+    return !seen.insert(solution.hash).second;
+  });
+
+  if (stats != nullptr) {
+    stats->candidates = candidates.size();
+    stats->solutions = solutions.size();
+    stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  }
+
+  return solutions;
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+#include "LifeAPI.hpp"
+#include "Collision.hpp"
+#include "LifePacked.hpp"
+#include "Threads.hpp"
+
+// An apgsearch-style census: random soups are run until they settle, the
+// ash is split into objects, and every object is counted by its
+// canonical hash.
+
+// A queue with a fixed capacity between two pipeline stages. `Push`
+// blocks while it is full and `Pop` blocks while it is empty; after
+// `Close`, `Pop` drains what is left and then returns nothing.
+template <typename T>
+class BoundedQueue {
+public:
+  explicit BoundedQueue(size_t capacity) : capacity{capacity} {}
+
+  bool Push(T item) {
+    std::unique_lock<std::mutex> lock(mutex);
+    notFull.wait(lock, [&] { return items.size() < capacity || closed; });
+    if (closed)
+      return false;
+    items.push_back(std::move(item));
+    notEmpty.notify_one();
+    return true;
+  }
+
+  std::optional<T> Pop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    notEmpty.wait(lock, [&] { return !items.empty() || closed; });
+    if (items.empty())
+      return std::nullopt;
+    T item = std::move(items.front());
+    items.pop_front();
+    notFull.notify_one();
+    return item;
+  }
+
+  void Close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    notFull.notify_all();
+    notEmpty.notify_all();
+  }
+
+private:
+  size_t capacity;
+  std::deque<T> items;
+  bool closed = false;
+  std::mutex mutex;
+  std::condition_variable notFull;
+  std::condition_variable notEmpty;
+};
+
+struct CensusEntry {
+  uint64_t count = 0;
+  LifeStatePackedDynamic object; // One example, in whichever phase it was found
+};
+
+// A hash map split into independently locked shards, so threads adding
+// different objects rarely wait on each other
+class ShardedCounter {
+public:
+  static constexpr unsigned shards = 64;
+
+  void Add(uint64_t hash, uint64_t count, const LifeStatePackedDynamic &object) {
+    Shard &shard = shardArray[hash % shards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    CensusEntry &entry = shard.counts[hash];
+    if (entry.count == 0)
+      entry.object = object;
+    entry.count += count;
+  }
+
+  void Add(const std::unordered_map<uint64_t, CensusEntry> &local) {
+    for (auto &[hash, entry] : local)
+      Add(hash, entry.count, entry.object);
+  }
+
+  std::unordered_map<uint64_t, CensusEntry> Merged() const {
+    std::unordered_map<uint64_t, CensusEntry> result;
+    for (auto &shard : shardArray) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      result.insert(shard.counts.begin(), shard.counts.end());
+    }
+    return result;
+  }
+
+private:
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<uint64_t, CensusEntry> counts;
+  };
+  std::array<Shard, shards> shardArray;
+};
+
+struct CensusParams {
+  uint64_t soups = 1000;
+  uint64_t seed = 0;             // Soup i is the same for a given seed
+  unsigned soupSize = 16;        // Soups fill a square this wide
+  unsigned maxGeneration = 2000;
+  unsigned maxPeriod = 30;       // Longer oscillators are never noticed
+  unsigned gliderClearance = 16;
+  unsigned threads = 0;          // Workers, 0 for one per core
+  unsigned batchSize = 16;       // Soups passed between stages at once
+  unsigned queueBatches = 4;     // Batches waiting per worker
+};
+
+struct CensusResult {
+  std::unordered_map<uint64_t, CensusEntry> objects;
+  uint64_t soups = 0;
+  uint64_t unsettled = 0; // Soups still going at maxGeneration
+  double seconds = 0;
+
+  double SoupsPerSecond() const {
+    return seconds > 0 ? soups / seconds : 0;
+  }
+
+  // Most common first
+  std::vector<std::pair<uint64_t, CensusEntry>> Sorted() const {
+    std::vector<std::pair<uint64_t, CensusEntry>> result(objects.begin(), objects.end());
+    std::sort(result.begin(), result.end(), [](const auto &a, const auto &b) {
+      return a.second.count > b.second.count || (a.second.count == b.second.count && a.first < b.first);
+    });
+    return result;
+  }
+};
+
+class Census {
+public:
+  explicit Census(const CensusParams &params = CensusParams()) : params{params} {}
+
+  LifeState Soup(uint64_t index) const {
+    PRNG::Xoshiro256x4 generator(params.seed ^ (index * 0x9E3779B97F4A7C15ULL));
+    int corner = -(int)params.soupSize / 2;
+    return LifeState::RandomState(generator) &
+           LifeState::SolidRect(corner, corner, params.soupSize, params.soupSize);
+  }
+
+  // Runs a soup until it is periodic and tallies its objects into
+  // `counts`. Returns false if it didn't settle in time.
+  bool Tally(const LifeState &soup, std::unordered_map<uint64_t, CensusEntry> &counts) const;
+
+  CensusResult Run() const;
+
+private:
+  CensusParams params;
+};
+
+inline bool Census::Tally(const LifeState &soup,
+                          std::unordered_map<uint64_t, CensusEntry> &counts) const {
+  LifeState current = soup;
+  std::vector<EmittedGlider> gliders;
+  std::vector<uint64_t> history = {current.GetHash()};
+  unsigned period = 0;
+
+  for (unsigned gen = 1; gen <= params.maxGeneration && period == 0; gen++) {
+    current.Step();
+    // Finding components is slow, and a glider only needs to be gone
+    // before it wraps round
+    if (gen % 16 == 0)
+      CollisionEnumerator::RemoveGliders(current, gen, params.gliderClearance, gliders);
+
+    uint64_t hash = current.GetHash();
+    for (unsigned p = 1; p <= params.maxPeriod && p <= gen; p++) {
+      if (history[gen - p] == hash) {
+        period = p;
+        break;
+      }
+    }
+    history.push_back(hash);
+  }
+
+  if (period == 0)
+    return false;
+
+  thread_local std::vector<LifeState> components;
+  current.Components(components);
+  for (auto &component : components) {
+    // Oscillators get the same hash whatever phase they stopped in
+    uint64_t hash = CollisionEnumerator::CanonicalHash(component);
+    LifeState phase = component;
+    for (unsigned i = 1; i < period; i++) {
+      phase.Step();
+      hash = std::min(hash, CollisionEnumerator::CanonicalHash(phase));
+    }
+
+    CensusEntry &entry = counts[hash];
+    if (entry.count == 0)
+      entry.object = LifeStatePackedDynamic(component);
+    entry.count++;
+  }
+
+  if (!gliders.empty()) {
+    LifeState glider = LifeState::ConstantParse("bo$2bo$3o!");
+    CensusEntry &entry = counts[CollisionEnumerator::CanonicalHash(glider)];
+    if (entry.count == 0)
+      entry.object = LifeStatePackedDynamic(glider);
+    entry.count += gliders.size();
+  }
+
+  return true;
+}
+
+inline CensusResult Census::Run() const {
+  auto startTime = std::chrono::steady_clock::now();
+
+  unsigned threads = ThreadCount(params.threads);
+
+  // Making a soup is tiny next to running it, so one thread keeps all
+  // the workers fed
+  BoundedQueue<std::vector<LifeState>> soupQueue(threads * params.queueBatches);
+  ShardedCounter counter;
+  std::atomic<uint64_t> unsettled = 0;
+
+  std::thread generator([&]() {
+    for (uint64_t begin = 0; begin < params.soups; begin += params.batchSize) {
+      std::vector<LifeState> batch;
+      for (uint64_t i = begin; i < std::min(begin + params.batchSize, params.soups); i++)
+        batch.push_back(Soup(i));
+      soupQueue.Push(std::move(batch));
+    }
+    soupQueue.Close();
+  });
+
+  auto worker = [&]() {
+    // Counted locally and merged once per batch, which keeps the shared
+    // counter out of the inner loop
+    std::unordered_map<uint64_t, CensusEntry> local;
+    while (auto batch = soupQueue.Pop()) {
+      for (auto &soup : *batch) {
+        if (!Tally(soup, local))
+          unsettled++;
+      }
+      counter.Add(local);
+      local.clear();
+    }
+  };
+
+  RunWorkers(threads, worker);
+  generator.join();
+
+  CensusResult result;
+  result.objects = counter.Merged();
+  result.soups = params.soups;
+  result.unsettled = unsettled;
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  return result;
+}
@@ -0,0 +1,334 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <optional>
+#include <unordered_set>
+
+#include "LifeAPI.hpp"
+#include "Symmetry.hpp"
+#include "Threads.hpp"
+
+// Enumerates every way two objects (say a glider and a still life) can
+// collide, runs each collision until it settles, and reports what is
+// left behind.
+//
+// If either object is a spaceship, only collisions where they meet from
+// far away count, so every lane and timing turns up exactly once.
+
+struct CollisionPlacement {
+  unsigned firstPhase;         // Generations the first object is run first
+  unsigned secondPhase;        // Likewise for the second
+  SymmetryTransform transform; // Then applied to the second object
+  std::pair<int, int> offset;  // Then moved by this
+
+  auto operator<=>(const CollisionPlacement &) const = default;
+};
+
+struct EmittedGlider {
+  std::pair<int, int> direction; // Cells moved every 4 generations
+  unsigned generation;           // When it was removed from the pattern
+};
+
+struct CollisionResult {
+  CollisionPlacement placement;
+  LifeState start;
+  uint64_t hash;        // CanonicalHash of the start
+
+  bool settled;         // False if maxGeneration ran out first
+  unsigned generation;  // When the products became periodic
+  unsigned period;
+  LifeState debris;     // Everything but the gliders at `generation`
+
+  std::vector<uint64_t> products; // CanonicalHash of each object, sorted
+  std::vector<EmittedGlider> gliders;
+};
+
+struct CollisionParams {
+  unsigned maxGeneration = 256;
+  unsigned maxPeriod = 4;        // Longer oscillators are never noticed
+  unsigned gliderClearance = 16; // How far a glider has to be clear ahead
+  unsigned threads = 0;          // 0 for one per core
+  unsigned batchSize = 64;       // Collisions taken by a thread at once
+};
+
+struct CollisionStats {
+  uint64_t candidates = 0; // Before removing symmetric duplicates
+  uint64_t collisions = 0;
+  uint64_t settled = 0;
+  double seconds = 0;
+
+  double CollisionsPerSecond() const {
+    return seconds > 0 ? collisions / seconds : 0;
+  }
+};
+
+class CollisionEnumerator {
+public:
+  CollisionEnumerator(const LifeState &first, const LifeState &second,
+                      const CollisionParams &params = CollisionParams())
+      : first{first}, second{second}, params{params} {
+    firstPeriod = Period(first, params.maxPeriod);
+    secondPeriod = Period(second, params.maxPeriod);
+    span = std::lcm(firstPeriod, secondPeriod);
+    firstMotion = Motion(first, span).value_or(std::make_pair(0, 0));
+  }
+
+  // Hash of a small object that doesn't depend on its position or
+  // orientation
+  static uint64_t CanonicalHash(const LifeState &object) {
+    // `GetOctoHash` needs the object away from the x/y = 32 seam
+    auto cell = object.FirstOn();
+    return object.Moved(-cell.first, -cell.second).GetOctoHash();
+  }
+
+  // The direction of travel, if `component` is a lone glider
+  static std::optional<std::pair<int, int>> GliderDirection(const LifeState &component);
+
+  // Removes gliders that are clear of everything else for `clearance`
+  // cells ahead, so they can't wrap round the torus and hit it again
+  static void RemoveGliders(LifeState &state, unsigned generation, unsigned clearance,
+                            std::vector<EmittedGlider> &gliders);
+
+  // One placement per collision, up to the symmetry of the pair
+  std::vector<CollisionPlacement> Placements(uint64_t *candidates = nullptr) const;
+
+  CollisionResult Evolve(const CollisionPlacement &placement) const;
+
+  std::vector<CollisionResult> Run(CollisionStats *stats = nullptr) const;
+
+private:
+  LifeState first;
+  LifeState second;
+  CollisionParams params;
+
+  // 1 for objects that don't repeat within maxPeriod
+  unsigned firstPeriod;
+  unsigned secondPeriod;
+  // Both are back in the same phase after this many generations
+  unsigned span;
+  std::pair<int, int> firstMotion;
+
+  // How far `object` moves in `generations`, if it repeats then
+  static std::optional<std::pair<int, int>> Motion(const LifeState &object, unsigned generations);
+  static unsigned Period(const LifeState &object, unsigned maxPeriod);
+
+  LifeState First(const CollisionPlacement &placement) const {
+    return first.Stepped(placement.firstPhase);
+  }
+
+  LifeState Second(const CollisionPlacement &placement) const {
+    return second.Stepped(placement.secondPhase).Transformed(placement.transform).Moved(placement.offset);
+  }
+
+  LifeState Start(const CollisionPlacement &placement) const {
+    return First(placement) | Second(placement);
+  }
+
+  // Whether the second object could have got here without touching
+  // the first one on the way
+  bool Approaches(const CollisionPlacement &placement, std::pair<int, int> motion) const;
+
+};
+
+inline std::optional<std::pair<int, int>>
+CollisionEnumerator::GliderDirection(const LifeState &component) {
+  if (component.GetPop() != 5)
+    return std::nullopt;
+
+  LifeState later = component.Stepped(4);
+  for (int dx : {-1, 1})
+    for (int dy : {-1, 1})
+      if (later == Translated(component, dx, dy))
+        return std::make_pair(dx, dy);
+
+  return std::nullopt;
+}
+
+inline std::optional<std::pair<int, int>>
+CollisionEnumerator::Motion(const LifeState &object, unsigned generations) {
+  LifeState later = object.Stepped(generations);
+  for (int dx = -(int)generations; dx <= (int)generations; dx++)
+    for (int dy = -(int)generations; dy <= (int)generations; dy++)
+      if (later == Translated(object, dx, dy))
+        return std::make_pair(dx, dy);
+  return std::nullopt;
+}
+
+inline unsigned CollisionEnumerator::Period(const LifeState &object, unsigned maxPeriod) {
+  for (unsigned p = 1; p <= maxPeriod; p++)
+    if (Motion(object, p))
+      return p;
+  return 1;
+}
+
+inline bool CollisionEnumerator::Approaches(const CollisionPlacement &placement,
+                                            std::pair<int, int> motion) const {
+  // Two stationary objects can only be put next to each other, and two
+  // ships with the same velocity never meet
+  if (motion == firstMotion)
+    return motion == std::make_pair(0, 0);
+
+  // `span` generations earlier both were in the same phase, just further
+  // back along their paths
+  LifeState a = First(placement).Moved(-firstMotion.first, -firstMotion.second);
+  LifeState b = Second(placement).Moved(-motion.first, -motion.second);
+  LifeState both = a | b;
+  for (unsigned i = 0; i < span; i++) {
+    a.Step();
+    b.Step();
+    both.Step();
+    if (both != (a | b))
+      return false;
+  }
+  return true;
+}
+
+inline std::vector<CollisionPlacement>
+CollisionEnumerator::Placements(uint64_t *candidates) const {
+  std::vector<CollisionPlacement> result;
+  std::unordered_set<uint64_t> seen;
+  uint64_t count = 0;
+
+  for (unsigned firstPhase = 0; firstPhase < firstPeriod; firstPhase++) {
+    LifeState phasedFirst = first.Stepped(firstPhase);
+    for (unsigned secondPhase = 0; secondPhase < secondPeriod; secondPhase++) {
+      LifeState phased = second.Stepped(secondPhase);
+      for (auto t : phased.SymmetryOrbitRepresentatives()) {
+        LifeState transformed = phased.Transformed(t);
+        auto motion = Motion(transformed, span).value_or(std::make_pair(0, 0));
+        LifeState overlapping = phasedFirst.Convolve(transformed.Mirrored());
+        LifeState offsets = phasedFirst.InteractionOffsets(transformed) & ~overlapping;
+
+        for (auto offset : offsets.Cells()) {
+          CollisionPlacement placement = {firstPhase, secondPhase, t, offset};
+          if (!Approaches(placement, motion))
+            continue;
+          count++;
+          // Collisions that are the same under a symmetry of the pair
+          // have the same start up to a transformation
+          if (seen.insert(CanonicalHash(Start(placement))).second)
+            result.push_back(placement);
+        }
+      }
+    }
+  }
+
+  if (candidates != nullptr)
+    *candidates = count;
+
+  return result;
+}
+
+inline void CollisionEnumerator::RemoveGliders(LifeState &state, unsigned generation,
+                                               unsigned clearance,
+                                               std::vector<EmittedGlider> &gliders) {
+  if (state.GetPop() < 5)
+    return;
+
+  // Called every few generations of every collision, so keep the
+  // allocation around
+  thread_local std::vector<LifeState> components;
+  state.Components(components);
+  for (auto &component : components) {
+    auto direction = GliderDirection(component);
+    if (!direction)
+      continue;
+
+    LifeState path;
+    for (unsigned i = 0; i <= clearance; i++)
+      path |= Translated(component, i * direction->first, i * direction->second);
+
+    LifeState rest = state & ~component;
+    if ((path.BigZOI() & rest).IsEmpty()) {
+      state = rest;
+      gliders.push_back({*direction, generation});
+    }
+  }
+}
+
+inline CollisionResult CollisionEnumerator::Evolve(const CollisionPlacement &placement) const {
+  CollisionResult result = {placement, Start(placement), 0, false, 0, 0, LifeState(), {}, {}};
+  result.hash = CanonicalHash(result.start);
+
+  LifeState current = result.start;
+  std::vector<uint64_t> history = {current.GetHash()};
+
+  for (unsigned gen = 1; gen <= params.maxGeneration; gen++) {
+    current.Step();
+    // A glider is still a glider 4 generations later, so there is no
+    // need to look every generation
+    if (gen % 4 == 0)
+      RemoveGliders(current, gen, params.gliderClearance, result.gliders);
+
+    uint64_t hash = current.GetHash();
+    for (unsigned p = 1; p <= params.maxPeriod && p <= gen; p++) {
+      if (history[gen - p] == hash) {
+        result.settled = true;
+        result.generation = gen;
+        result.period = p;
+        break;
+      }
+    }
+    history.push_back(hash);
+
+    if (result.settled)
+      break;
+  }
+
+  result.debris = current;
+  if (!result.settled)
+    return result;
+
+  thread_local std::vector<LifeState> components;
+  current.Components(components);
+  for (auto &component : components) {
+    // Oscillators get the same hash whatever phase they stopped in
+    uint64_t hash = CanonicalHash(component);
+    LifeState phase = component;
+    for (unsigned i = 1; i < result.period; i++) {
+      phase.Step();
+      hash = std::min(hash, CanonicalHash(phase));
+    }
+    result.products.push_back(hash);
+  }
+  std::sort(result.products.begin(), result.products.end());
+
+  return result;
+}
+
+inline std::vector<CollisionResult> CollisionEnumerator::Run(CollisionStats *stats) const {
+  auto startTime = std::chrono::steady_clock::now();
+
+  uint64_t candidates = 0;
+  std::vector<CollisionPlacement> placements = Placements(&candidates);
+  std::vector<CollisionResult> results(placements.size());
+
+  std::atomic<size_t> next = 0;
+  auto worker = [&]() {
+    while (true) {
+      size_t begin = next.fetch_add(params.batchSize);
+      if (begin >= placements.size())
+        break;
+      size_t end = std::min(begin + params.batchSize, placements.size());
+
+      // Every collision has its own slot, so no locking needed
+      for (size_t i = begin; i < end; i++)
+        results[i] = Evolve(placements[i]);
+    }
+  };
+
+  RunWorkers(params.threads, worker);
+
+  if (stats != nullptr) {
+    stats->candidates = candidates;
+    stats->collisions = results.size();
+    stats->settled = std::count_if(results.begin(), results.end(),
+                                   [](const CollisionResult &r) { return r.settled; });
+    stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  }
+
+  return results;
+}
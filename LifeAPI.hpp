@@ -1,13 +1,18 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
-#include <random>
+#include <cmath>
+#include <iterator>
+#include <type_traits>
 #include <vector>
 
 #define XXH_INLINE_ALL 1
 #include "xxHash/xxhash.h"
 
 #include "Bits.hpp"
+#include "PRNG.hpp"
+#include "StaticVector.hpp"
 
 const int N = 64;
 
@@ -15,27 +20,63 @@ constexpr unsigned torus_wrap(int x) {
   return x & (N - 1); // Valid for negative x
 }
 
-namespace PRNG {
-static std::random_device rd;
-static std::mt19937_64 e2(rd());
-static std::uniform_int_distribution<uint64_t>
-    dist(std::llround(std::pow(2, 61)), std::llround(std::pow(2, 62)));
-} // namespace PRNG
-
 enum struct SymmetryTransform : uint32_t;
 enum struct StaticSymmetry : uint32_t;
 
 // See LifeTarget.hpp
 struct LifeTarget;
 
-// See LifeStrip.hpp
-struct StripIndex;
-struct LifeStateStrip;
-struct LifeStateStripProxy;
-struct LifeStateStripConstProxy;
+// See LifePacked.hpp
+template <unsigned W, unsigned H>
+struct LifeStatePacked;
+struct LifeStatePackedDynamic;
 
 enum class InitializedTag { UNINITIALIZED };
 
+class CellRange;
+
+// A pattern moved by (dx, dy) without doing the move: the LifeState
+// operators below take one of these and rotate each column as they go,
+// rather than building the moved copy first. `Translated(pat, dx, dy)`
+// holds a reference, so use it within the expression that made it.
+template <typename T>
+struct Translated {
+  T base;
+  int dx;
+  int dy;
+
+  constexpr Translated(T base, int dx, int dy) : base{base}, dx{dx}, dy{dy} {}
+  constexpr Translated(T base, std::pair<int, int> vec)
+      : base{base}, dx{vec.first}, dy{vec.second} {}
+
+  // Column i of `base.Moved(dx, dy)`
+  constexpr uint64_t operator[](const unsigned i) const {
+    return std::rotl(base[torus_wrap(i - dx)], dy);
+  }
+
+  // Calls `f(i, (*this)[i])` for every column. Done as two runs that
+  // don't wrap, so that the loops vectorise.
+  template <typename F>
+  constexpr void ForEachColumn(F f) const {
+    const unsigned shift = torus_wrap(dx);
+    const int rotation = torus_wrap(dy);
+    for (unsigned i = 0; i < shift; i++)
+      f(i, std::rotl(base[i + N - shift], rotation));
+    for (unsigned i = shift; i < N; i++)
+      f(i, std::rotl(base[i - shift], rotation));
+  }
+
+  // Stepping commutes with moving, so only the base needs to be run
+  auto Stepped(unsigned numIters = 1) const {
+    return ::Translated<std::remove_cvref_t<T>>(base.Stepped(numIters), dx, dy);
+  }
+};
+
+template <typename T>
+Translated(const T &, int, int) -> Translated<const T &>;
+template <typename T>
+Translated(const T &, std::pair<int, int>) -> Translated<const T &>;
+
 struct __attribute__((aligned(64))) LifeState {
   uint64_t state[N];
 
@@ -60,14 +101,50 @@ struct __attribute__((aligned(64))) LifeState {
     return result;
   }
 
-  static LifeState RandomState() {
+  // Each cell on with probability 1/2, from the generator the caller
+  // passes or else this thread's one
+  template <typename Generator>
+  static LifeState RandomState(Generator &generator) {
     LifeState result;
-    for (unsigned i = 0; i < N; i++)
-      result[i] = PRNG::dist(PRNG::e2);
+    if constexpr (requires { generator.Fill(result.state, N); }) {
+      generator.Fill(result.state, N);
+    } else {
+      for (unsigned i = 0; i < N; i++)
+        result[i] = generator();
+    }
+    return result;
+  }
+
+  static LifeState RandomState() {
+    return RandomState(PRNG::ThreadGenerator());
+  }
+
+  // Each cell on with probability `density`, rounded to a multiple of
+  // 1/256
+  template <typename Generator>
+  static LifeState RandomState(Generator &generator, double density) {
+    unsigned numerator = std::clamp((int)std::lround(density * 256), 0, 256);
+    if (numerator == 256)
+      return ~LifeState();
 
+    // Read the binary digits of the density from the least significant
+    // end: ORing in a fair coin maps p to (1 + p)/2, ANDing maps it to p/2
+    LifeState result;
+    if (numerator == 0)
+      return result;
+    for (unsigned bit = std::countr_zero(numerator); bit < 8; bit++) {
+      if (numerator & (1 << bit))
+        result |= RandomState(generator);
+      else
+        result &= RandomState(generator);
+    }
     return result;
   }
 
+  static LifeState RandomState(double density) {
+    return RandomState(PRNG::ThreadGenerator(), density);
+  }
+
   // State is parity of (x + y), so (0, 0) is OFF
   static LifeState Checkerboard() {
     // TODO: just constantparse it
@@ -173,9 +250,6 @@ struct __attribute__((aligned(64))) LifeState {
     }
   }
 
-  inline LifeStateStripProxy operator[](const StripIndex column);
-  inline const LifeStateStripConstProxy operator[](const StripIndex column) const;
-
   template <unsigned radius> uint64_t GetPatch(std::pair<int, int> cell) const {
     auto [x, y] = cell;
 
@@ -274,6 +348,52 @@ struct __attribute__((aligned(64))) LifeState {
     return *this;
   }
 
+  template <typename T>
+  bool operator==(const Translated<T> &b) const {
+    uint64_t diffs = 0;
+    b.ForEachColumn([&](unsigned i, uint64_t column) { diffs |= state[i] ^ column; });
+    return diffs == 0;
+  }
+
+  template <typename T>
+  LifeState operator&(const Translated<T> &other) const {
+    LifeState result(InitializedTag::UNINITIALIZED);
+    other.ForEachColumn([&](unsigned i, uint64_t column) { result[i] = state[i] & column; });
+    return result;
+  }
+
+  template <typename T>
+  LifeState &operator&=(const Translated<T> &other) {
+    other.ForEachColumn([&](unsigned i, uint64_t column) { state[i] &= column; });
+    return *this;
+  }
+
+  template <typename T>
+  LifeState operator|(const Translated<T> &other) const {
+    LifeState result(InitializedTag::UNINITIALIZED);
+    other.ForEachColumn([&](unsigned i, uint64_t column) { result[i] = state[i] | column; });
+    return result;
+  }
+
+  template <typename T>
+  LifeState &operator|=(const Translated<T> &other) {
+    other.ForEachColumn([&](unsigned i, uint64_t column) { state[i] |= column; });
+    return *this;
+  }
+
+  template <typename T>
+  LifeState operator^(const Translated<T> &other) const {
+    LifeState result(InitializedTag::UNINITIALIZED);
+    other.ForEachColumn([&](unsigned i, uint64_t column) { result[i] = state[i] ^ column; });
+    return result;
+  }
+
+  template <typename T>
+  LifeState &operator^=(const Translated<T> &other) {
+    other.ForEachColumn([&](unsigned i, uint64_t column) { state[i] ^= column; });
+    return *this;
+  }
+
   ////////////////////////////////
   // Queries
   ////////////////////////////////
@@ -354,6 +474,12 @@ struct __attribute__((aligned(64))) LifeState {
   // }
 
   inline std::vector<std::pair<int, int>> OnCells() const;
+  // Into `result`, which is cleared first
+  inline void OnCells(std::vector<std::pair<int, int>> &result) const;
+
+  // The on cells in column order, without allocating:
+  // `for (auto cell : state.Cells())`
+  inline CellRange Cells() const;
 
   LifeState FirstCell() const { return LifeState::Cell(FirstOn()); }
 
@@ -396,33 +522,39 @@ struct __attribute__((aligned(64))) LifeState {
     return differences == 0;
   }
 
-  bool Contains(const LifeState &pat, int targetDx, int targetDy) const {
-    int dy = torus_wrap(targetDy);
+  template <typename T>
+  bool Contains(const Translated<T> &pat) const {
+    uint64_t differences = 0;
+    pat.ForEachColumn([&](unsigned i, uint64_t column) { differences |= (state[i] & column) ^ column; });
+    return differences == 0;
+  }
 
-    for (unsigned i = 0; i < N; i++) {
-      int curX = torus_wrap(i + targetDx);
+  template <typename T>
+  bool AreDisjoint(const Translated<T> &pat) const {
+    uint64_t overlap = 0;
+    pat.ForEachColumn([&](unsigned i, uint64_t column) { overlap |= state[i] & column; });
+    return overlap == 0;
+  }
 
-      if ((std::rotr(state[curX], dy) & pat[i]) != (pat[i]))
-        return false;
-    }
-    return true;
+  bool Contains(const LifeState &pat, int targetDx, int targetDy) const {
+    return Contains(Translated(pat, targetDx, targetDy));
   }
 
   bool AreDisjoint(const LifeState &pat, int targetDx, int targetDy) const {
-    int dy = torus_wrap(targetDy);
-
-    for (unsigned i = 0; i < N; i++) {
-      int curX = torus_wrap(i + targetDx);
-
-      if (((~std::rotr(state[curX], dy)) & pat[i]) != pat[i])
-        return false;
-    }
-
-    return true;
+    return AreDisjoint(Translated(pat, targetDx, targetDy));
   }
 
   inline bool Contains(const LifeTarget &target, int dx, int dy) const;
   inline bool Contains(const LifeTarget &target) const;
+  inline bool Contains(const Translated<const LifeTarget &> &target) const;
+
+  // `pat` with its corner at `offset`
+  template <unsigned W, unsigned H>
+  inline bool Contains(const LifeStatePacked<W, H> &pat, std::pair<int, int> offset) const;
+  template <unsigned W, unsigned H>
+  inline bool AreDisjoint(const LifeStatePacked<W, H> &pat, std::pair<int, int> offset) const;
+  inline bool Contains(const LifeStatePackedDynamic &pat, std::pair<int, int> offset) const;
+  inline bool AreDisjoint(const LifeStatePackedDynamic &pat, std::pair<int, int> offset) const;
 
   LifeState MatchLive(const LifeState &live) const {
     LifeState invThis = ~*this;
@@ -666,13 +798,20 @@ struct __attribute__((aligned(64))) LifeState {
 
   std::vector<LifeState> Components(const LifeState &corona) const {
     std::vector<LifeState> result;
+    Components(corona, result);
+    return result;
+  }
+
+  // Into `result`, which is cleared first. Reusing the same vector across
+  // calls saves allocating every time.
+  void Components(const LifeState &corona, std::vector<LifeState> &result) const {
+    result.clear();
     LifeState remaining = *this;
     while (!remaining.IsEmpty()) {
       LifeState component = remaining.ComponentContaining(remaining.FirstCell(), corona);
       result.push_back(component);
       remaining &= ~component;
     }
-    return result;
   }
 
   ////////////////////////////////
@@ -805,13 +944,20 @@ struct __attribute__((aligned(64))) LifeState {
     Transform(transf);
   }
 
-  inline std::vector<LifeState> SymmetryOrbit() const;
-  inline std::vector<SymmetryTransform> SymmetryOrbitRepresentatives() const;
+  inline StaticVector<LifeState, 8> SymmetryOrbit() const;
+  inline StaticVector<SymmetryTransform, 8> SymmetryOrbitRepresentatives() const;
 
   LifeState Halve() const;
   LifeState HalveX() const;
   LifeState HalveY() const;
 
+  // (x, y) |-> (2x, 2y), (2x, y) and (x, 2y), the other way round from
+  // the Halve functions. Halving after doubling gives back anything that
+  // repeats every 32 cells, as halved patterns do.
+  LifeState Double() const;
+  LifeState DoubleX() const;
+  LifeState DoubleY() const;
+
   LifeState Skew() const;
   LifeState InvSkew() const;
 
@@ -834,7 +980,7 @@ struct __attribute__((aligned(64))) LifeState {
 
   // From Page 5 of
   // https://www.gathering4gardner.org/g4g13gift/math/RokickiTomas-GiftExchange-LifeAlgorithms-G4G13.pdf
-  uint64_t inline Rokicki(const uint64_t &a, const uint64_t &bU0,
+  static uint64_t inline Rokicki(const uint64_t &a, const uint64_t &bU0,
                           const uint64_t &bU1, const uint64_t &bB0,
                           const uint64_t &bB1) {
     uint64_t aw = std::rotl(a, 1);
@@ -1090,7 +1236,45 @@ struct __attribute__((aligned(64))) LifeState {
       (a_out3 & a_state).Convolve((b_bit3 | b_bit2 | b_bit1) & ~b_state) |
       ((a_bit2 | a_bit3) & a_state).Convolve((b_bit3 | b_bit2 | b_bit1 | b_bit0) & ~b_state) |
       (b_out3 & b_state).Convolve((a_bit3 | a_bit2 | a_bit1) & ~a_state) |
-      ((b_bit2 | b_bit3) & b_state).Convolve((a_bit3 | a_bit2 | a_bit1 | a_bit0) & ~a_state)
+      ((b_bit2 | b_bit3) & b_state).Convolve((a_bit3 | a_bit2 | a_bit1 | a_bit0) & ~a_state) |
+      // The rest only happen next to cells that are about to change
+      ActiveInteractionOffsets(a_state, a_bit3, a_bit2, a_bit1, a_bit0,
+                               b_state, b_bit3, b_bit2, b_bit1, b_bit0)
+      ;
+  }
+
+  static LifeState ActiveInteractionOffsets(
+      const LifeState &a_state, const LifeState &a_bit3, const LifeState &a_bit2,
+      const LifeState &a_bit1, const LifeState &a_bit0,
+      const LifeState &b_state, const LifeState &b_bit3, const LifeState &b_bit2,
+      const LifeState &b_bit1, const LifeState &b_bit0) {
+    LifeState a_out1 = ~a_bit3 & ~a_bit2 & ~a_bit1 &  a_bit0;
+    LifeState a_out2 = ~a_bit3 & ~a_bit2 &  a_bit1 & ~a_bit0;
+    LifeState a_out3 = ~a_bit3 & ~a_bit2 &  a_bit1 &  a_bit0;
+    LifeState b_out1 = ~b_bit3 & ~b_bit2 & ~b_bit1 &  b_bit0;
+    LifeState b_out2 = ~b_bit3 & ~b_bit2 &  b_bit1 & ~b_bit0;
+    LifeState b_out3 = ~b_bit3 & ~b_bit2 &  b_bit1 &  b_bit0;
+
+    // Births and deaths on their own
+    LifeState a_active = (a_out3 & ~a_state) | ((a_out1 | a_out2) & a_state);
+    LifeState b_active = (b_out3 & ~b_state) | ((b_out1 | b_out2) & b_state);
+    if (a_active.IsEmpty() && b_active.IsEmpty())
+      return LifeState();
+
+    LifeState a_any = (a_bit3 | a_bit2 | a_bit1 | a_bit0) & ~a_state;
+    LifeState b_any = (b_bit3 | b_bit2 | b_bit1 | b_bit0) & ~b_state;
+    LifeState a_few = (a_out1 | a_out2 | a_out3) & ~a_state;
+    LifeState b_few = (b_out1 | b_out2 | b_out3) & ~b_state;
+
+    return
+      // Births that get overcrowded
+      (a_out3 & ~a_state).Convolve(b_any) |
+      (b_out3 & ~b_state).Convolve(a_any) |
+      // Deaths from isolation that get saved
+      (a_out1 & a_state).Convolve(b_out2 & ~b_state) |
+      (b_out1 & b_state).Convolve(a_out2 & ~a_state) |
+      (a_out2 & a_state).Convolve(b_few) |
+      (b_out2 & b_state).Convolve(a_few)
       ;
   }
 
@@ -1145,6 +1329,8 @@ struct __attribute__((aligned(64))) LifeState {
         break;
       }
       case '$': {
+        if (cnt == 0)
+          cnt = 1;
         y += cnt;
         x = 0;
         cnt = 0;
@@ -1187,12 +1373,71 @@ struct __attribute__((aligned(64))) LifeState {
     return ComponentContaining(seed, corona);
   }
   std::vector<LifeState> Components() const {
+    std::vector<LifeState> result;
+    Components(result);
+    return result;
+  }
+  void Components(std::vector<LifeState> &result) const {
     constexpr LifeState corona =
         LifeState::ConstantParse("b3o$5o$5o$5o$b3o!", -2, -2);
-    return Components(corona);
+    Components(corona, result);
   }
 };
 
+// Walks the columns once, clearing the lowest bit of each as it goes, so
+// this is O(population + N). Holds its own copy of the state, so it is
+// fine to iterate over a temporary.
+class CellRange {
+public:
+  class Iterator {
+  public:
+    using value_type = std::pair<int, int>;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() = default;
+    Iterator(const uint64_t *columns) : columns{columns}, column{0}, remaining{columns[0]} {
+      SkipEmpty();
+    }
+
+    std::pair<int, int> operator*() const {
+      return {column, std::countr_zero(remaining)};
+    }
+
+    Iterator &operator++() {
+      remaining &= remaining - 1;
+      SkipEmpty();
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator result = *this;
+      ++*this;
+      return result;
+    }
+
+    bool operator==(std::default_sentinel_t) const { return column == N; }
+
+  private:
+    const uint64_t *columns = nullptr;
+    int column = N;
+    uint64_t remaining = 0;
+
+    void SkipEmpty() {
+      while (remaining == 0 && ++column < N)
+        remaining = columns[column];
+    }
+  };
+
+  explicit CellRange(const LifeState &state) : state{state} {}
+
+  Iterator begin() const { return Iterator(state.state); }
+  std::default_sentinel_t end() const { return {}; }
+
+private:
+  LifeState state;
+};
+
+inline CellRange LifeState::Cells() const { return CellRange(*this); }
+
 void LifeState::Step() {
   LifeState col0(InitializedTag::UNINITIALIZED), col1(InitializedTag::UNINITIALIZED);
   CountRows(col0, col1);
@@ -1370,13 +1615,15 @@ LifeState LifeState::Convolve(const LifeState &other) const {
 }
 
 std::vector<std::pair<int, int>> LifeState::OnCells() const {
-  LifeState remaining = *this;
   std::vector<std::pair<int, int>> result;
-  for (int pop = remaining.GetPop(); pop > 0; pop--) {
-    auto cell = remaining.FirstOn();
-    result.push_back(cell);
-    remaining.Erase(cell.first, cell.second);
-  }
+  OnCells(result);
   return result;
 }
 
+void LifeState::OnCells(std::vector<std::pair<int, int>> &result) const {
+  result.clear();
+  result.reserve(GetPop());
+  for (auto cell : Cells())
+    result.push_back(cell);
+}
+
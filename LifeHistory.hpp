@@ -1,8 +1,16 @@
 #pragma once
 
+#include <optional>
+
 #include "LifeAPI.hpp"
 #include "Parsing.hpp"
 
+// Where a `LifeHistory` first had a live cell in its marked layer
+struct MarkedHit {
+  unsigned generation; // The first step is generation 1
+  std::pair<int, int> cell;
+};
+
 // This uses lifelib "layers" which do not match Golly's state names,
 // so the parsing has to adjust for this.
 struct LifeHistory {
@@ -57,9 +65,49 @@ struct LifeHistory {
     auto offset = state.Match(other).FirstOn();
     Move(-offset.first, -offset.second);
   }
+
+  // Steps `state` and ORs each generation into `history` in the same pass
+  void Step() { StepFused<false>(); }
+  void Step(unsigned numIters) {
+    for (unsigned i = 0; i < numIters; i++)
+      StepFused<false>();
+  }
+
+  // As `Step(maxIters)`, but stops as soon as a live cell is in `marked`,
+  // the forbidden zone of a search, and says where
+  std::optional<MarkedHit> StepUntilMarked(unsigned maxIters);
+
+private:
+  // The live cells now in `marked`, if `checkMarked`
+  template <bool checkMarked> uint64_t StepFused();
 };
 
-std::string LifeHistory::RLE() const {
+template <bool checkMarked> inline uint64_t LifeHistory::StepFused() {
+  LifeState col0(InitializedTag::UNINITIALIZED), col1(InitializedTag::UNINITIALIZED);
+  state.CountRows(col0, col1);
+
+  uint64_t hits = 0;
+  for (unsigned i = 0; i < N; i++) {
+    unsigned idxU = i == 0 ? N - 1 : i - 1;
+    unsigned idxB = i == N - 1 ? 0 : i + 1;
+
+    uint64_t next = LifeState::Rokicki(state[i], col0[idxU], col1[idxU], col0[idxB], col1[idxB]);
+    state[i] = next;
+    history[i] |= next;
+    if constexpr (checkMarked)
+      hits |= next & marked[i];
+  }
+  return hits;
+}
+
+inline std::optional<MarkedHit> LifeHistory::StepUntilMarked(unsigned maxIters) {
+  for (unsigned gen = 1; gen <= maxIters; gen++)
+    if (StepFused<true>() != 0)
+      return MarkedHit{gen, (state & marked).FirstOn()};
+  return std::nullopt;
+}
+
+inline std::string LifeHistory::RLE() const {
   return GenericRLE([&](int x, int y) -> char {
     unsigned val = state.Get(x, y) + (history.Get(x, y) << 1) + (marked.Get(x, y) << 2) + (original.Get(x, y) << 3);
 
@@ -67,7 +115,7 @@ std::string LifeHistory::RLE() const {
   });
 }
 
-LifeHistory LifeHistory::Parse(const std::string &rle) {
+inline LifeHistory LifeHistory::Parse(const std::string &rle) {
   return GenericParse<LifeHistory>(rle, [&](LifeHistory &result, char ch, int x, int y) -> void {
     switch(ch) {
     case 'A':
@@ -91,7 +139,7 @@ LifeHistory LifeHistory::Parse(const std::string &rle) {
   });
 }
 
-LifeHistory LifeHistory::ParseBellman(const std::string &rle) {
+inline LifeHistory LifeHistory::ParseBellman(const std::string &rle) {
   return GenericParse<LifeHistory>(rle, [&](LifeHistory &result, char ch, int x, int y) -> void {
     switch(ch) {
     case 'C':
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <optional>
+#include <type_traits>
+
+#include "LifeAPI.hpp"
+#include "Symmetry.hpp"
+
+// Small patterns stored as just their bounding box. A LifeState is 512
+// bytes however little it holds, which adds up in libraries, dedup
+// tables and result lists full of 5x5 objects.
+//
+// A packed pattern has no position of its own: cell (0, 0) is the corner
+// of the box, and `ToState(offset)` puts it back at `offset`.
+
+// At most W columns of H cells, each column the smallest unsigned type
+// that fits
+template <unsigned W, unsigned H>
+struct LifeStatePacked {
+  static_assert(W >= 1 && W <= N && H >= 1 && H <= 64);
+
+  using Word = std::conditional_t<
+      H <= 8, uint8_t,
+      std::conditional_t<H <= 16, uint16_t,
+                         std::conditional_t<H <= 32, uint32_t, uint64_t>>>;
+
+  static constexpr uint64_t heightMask = H == 64 ? ~0ULL : (1ULL << H) - 1;
+
+  std::array<Word, W> columns{};
+
+  LifeStatePacked() = default;
+
+  // The W x H rectangle of `state` with its corner at `origin`
+  LifeStatePacked(const LifeState &state, std::pair<int, int> origin) {
+    for (unsigned i = 0; i < W; i++)
+      columns[i] = std::rotr(state[torus_wrap(origin.first + i)], origin.second) & heightMask;
+  }
+
+  // Cropped to the bounding box, or nothing if that is bigger than W x H.
+  // Like `XYBounds`, this needs the pattern away from the x/y = 32 seam.
+  static std::optional<LifeStatePacked> Cropped(const LifeState &state,
+                                                std::pair<int, int> *origin = nullptr) {
+    auto [x0, y0, x1, y1] = state.XYBounds();
+    if (x1 - x0 >= (int)W || y1 - y0 >= (int)H)
+      return std::nullopt;
+    if (origin != nullptr)
+      *origin = {x0, y0};
+    return LifeStatePacked(state, {x0, y0});
+  }
+
+  LifeState ToState(std::pair<int, int> offset = {0, 0}) const {
+    LifeState result;
+    for (unsigned i = 0; i < W; i++)
+      result[torus_wrap(offset.first + i)] = std::rotl((uint64_t)columns[i], offset.second);
+    return result;
+  }
+
+  static constexpr unsigned Width() { return W; }
+  static constexpr unsigned Height() { return H; }
+  uint64_t Column(unsigned i) const { return columns[i]; }
+
+  bool Get(unsigned x, unsigned y) const { return (columns[x] >> y) & 1; }
+
+  unsigned GetPop() const {
+    unsigned pop = 0;
+    for (auto column : columns)
+      pop += std::popcount(column);
+    return pop;
+  }
+
+  bool IsEmpty() const {
+    Word all = 0;
+    for (auto column : columns)
+      all |= column;
+    return all == 0;
+  }
+
+  bool operator==(const LifeStatePacked &) const = default;
+
+  // Of the packed bytes, for tables of packed patterns
+  uint64_t GetHash() const { return XXH3_64bits(columns.data(), sizeof(columns)); }
+
+  // Agrees with `GetOctoHash` of the pattern placed anywhere off the
+  // x = 32 column and the y = 32 row. The box is hashed with its corner
+  // at the origin, so that only holds up to 32 x 32.
+  uint64_t GetOctoHash() const {
+    static_assert(W <= 32 && H <= 32, "GetOctoHash needs a box of at most 32 x 32");
+    return ToState().GetOctoHash();
+  }
+};
+
+// Any size up to the whole torus. The columns are stored end to end
+// rather than padded to a word each, so a 5x5 eater takes one uint64_t.
+struct LifeStatePackedDynamic {
+  unsigned width = 0;
+  unsigned height = 0;
+  std::vector<uint64_t> bits; // Column i is bits [i * height, (i + 1) * height)
+
+  LifeStatePackedDynamic() = default;
+
+  // The `width` x `height` rectangle of `state` with its corner at `origin`
+  LifeStatePackedDynamic(const LifeState &state, std::pair<int, int> origin,
+                         unsigned width, unsigned height)
+      : width{width}, height{height}, bits((width * height + 63) / 64, 0) {
+    uint64_t heightMask = height == 64 ? ~0ULL : (1ULL << height) - 1;
+    for (unsigned i = 0; i < width; i++)
+      SetColumn(i, std::rotr(state[torus_wrap(origin.first + i)], origin.second) & heightMask);
+  }
+
+  // Cropped to the bounding box. Like `XYBounds`, this needs the pattern
+  // away from the x/y = 32 seam.
+  explicit LifeStatePackedDynamic(const LifeState &state, std::pair<int, int> *origin = nullptr) {
+    auto [x0, y0, x1, y1] = state.XYBounds();
+    if (origin != nullptr)
+      *origin = {x0, y0};
+    if (state.IsEmpty())
+      return;
+    *this = LifeStatePackedDynamic(state, {x0, y0}, x1 - x0 + 1, y1 - y0 + 1);
+  }
+
+  LifeState ToState(std::pair<int, int> offset = {0, 0}) const {
+    LifeState result;
+    for (unsigned i = 0; i < width; i++)
+      result[torus_wrap(offset.first + i)] = std::rotl(Column(i), offset.second);
+    return result;
+  }
+
+  unsigned Width() const { return width; }
+  unsigned Height() const { return height; }
+
+  uint64_t Column(unsigned i) const {
+    unsigned start = i * height;
+    unsigned word = start / 64;
+    unsigned shift = start % 64;
+    uint64_t column = bits[word] >> shift;
+    if (shift + height > 64)
+      column |= bits[word + 1] << (64 - shift);
+    return height == 64 ? column : column & ((1ULL << height) - 1);
+  }
+
+  bool Get(unsigned x, unsigned y) const { return (Column(x) >> y) & 1; }
+
+  unsigned GetPop() const {
+    unsigned pop = 0;
+    for (auto word : bits)
+      pop += std::popcount(word);
+    return pop;
+  }
+
+  bool IsEmpty() const { return GetPop() == 0; }
+
+  bool operator==(const LifeStatePackedDynamic &) const = default;
+
+  uint64_t GetHash() const {
+    uint64_t seed = (uint64_t)width << 32 | height;
+    return XXH3_64bits_withSeed(bits.data(), bits.size() * sizeof(uint64_t), seed);
+  }
+
+  // As for `LifeStatePacked`, only meaningful up to 32 x 32
+  uint64_t GetOctoHash() const { return ToState().GetOctoHash(); }
+
+private:
+  // Only ever ORs in, the bits start cleared
+  void SetColumn(unsigned i, uint64_t column) {
+    unsigned start = i * height;
+    unsigned word = start / 64;
+    unsigned shift = start % 64;
+    bits[word] |= column << shift;
+    if (shift + height > 64)
+      bits[word + 1] |= column >> (64 - shift);
+  }
+};
+
+// Only the packed columns are visited, rather than all N
+
+template <unsigned W, unsigned H>
+inline bool LifeState::Contains(const LifeStatePacked<W, H> &pat,
+                                std::pair<int, int> offset) const {
+  uint64_t differences = 0;
+  for (unsigned i = 0; i < W; i++) {
+    uint64_t column = std::rotl(pat.Column(i), offset.second);
+    differences |= (state[torus_wrap(offset.first + i)] & column) ^ column;
+  }
+  return differences == 0;
+}
+
+template <unsigned W, unsigned H>
+inline bool LifeState::AreDisjoint(const LifeStatePacked<W, H> &pat,
+                                   std::pair<int, int> offset) const {
+  uint64_t overlap = 0;
+  for (unsigned i = 0; i < W; i++)
+    overlap |= state[torus_wrap(offset.first + i)] & std::rotl(pat.Column(i), offset.second);
+  return overlap == 0;
+}
+
+inline bool LifeState::Contains(const LifeStatePackedDynamic &pat,
+                                std::pair<int, int> offset) const {
+  for (unsigned i = 0; i < pat.width; i++) {
+    uint64_t column = std::rotl(pat.Column(i), offset.second);
+    if ((state[torus_wrap(offset.first + i)] & column) != column)
+      return false;
+  }
+  return true;
+}
+
+inline bool LifeState::AreDisjoint(const LifeStatePackedDynamic &pat,
+                                   std::pair<int, int> offset) const {
+  for (unsigned i = 0; i < pat.width; i++)
+    if ((state[torus_wrap(offset.first + i)] & std::rotl(pat.Column(i), offset.second)) != 0)
+      return false;
+  return true;
+}
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <chrono>
+#include <functional>
+#include <unordered_set>
+
 #include "LifeAPI.hpp"
 #include "NeighbourCount.hpp"
 #include "Parsing.hpp"
+#include "Symmetry.hpp"
 
 enum class StableOptions : unsigned char {
   LIVE2 = 1 << 0,
@@ -19,7 +24,7 @@ enum class StableOptions : unsigned char {
   DEAD = DEAD0 | DEAD1 | DEAD2 | DEAD4 | DEAD5 | DEAD6,
 };
 
-StableOptions StableOptionsHighest(StableOptions t) {
+inline StableOptions StableOptionsHighest(StableOptions t) {
   if (t == StableOptions::IMPOSSIBLE) return StableOptions::IMPOSSIBLE;
 
   unsigned char bits = static_cast<unsigned char>(t);
@@ -34,7 +39,17 @@ constexpr inline StableOptions& operator|= (StableOptions& a, StableOptions b) {
 constexpr inline StableOptions& operator&= (StableOptions& a, StableOptions b) { a = a & b; return a; }
 constexpr inline StableOptions& operator^= (StableOptions& a, StableOptions b) { a = a ^ b; return a; }
 
+// How `CompleteStable` picks the next unknown cell to branch on
+enum class BranchHeuristic {
+  DEFAULT,          // Vulnerable cells, then cells with few unknown neighbours
+  MOST_CONSTRAINED, // Fewest remaining StableOptions
+  ACTIVITY,         // Cells that were recently involved in conflicts
+  SEED_DISTANCE,    // Closest to the starting pattern
+};
 
+struct StableConflictCache;
+struct StableSearchContext;
+struct StableCounts;
 
 class LifeStable {
 public:
@@ -131,10 +146,14 @@ public:
 
   PropagateResult SynchroniseStateKnown();
   PropagateResult UpdateOptions(); // Assumes counts and state/unknown are in sync
+  PropagateResult UpdateOptions(const NeighbourCount &stateCount, const NeighbourCount &offCount);
   PropagateResult StabiliseOptions(); // Apply the above two repeatedly
+  PropagateResult StabiliseOptions(StableCounts &counts);
 
   PropagateResult SignalNeighbours(); // Assumes counts and state/unknown are in sync
+  PropagateResult SignalNeighbours(const NeighbourCount &stateCount, const NeighbourCount &maxCount);
   PropagateResult PropagateStep();
+  PropagateResult PropagateStep(StableCounts &counts);
   PropagateResult Propagate();
 
   std::pair<uint64_t, uint64_t> SynchroniseStateKnownColumn(unsigned column);
@@ -189,10 +208,32 @@ public:
     TIMEOUT,
   };
 
-  CompletionResult CompleteStableStep(std::chrono::system_clock::time_point &timeLimit, bool minimise, bool useSeed, const LifeState &seed, unsigned &maxPop, LifeState &best);
-  std::pair<LifeStable::CompletionResult, LifeState> CompleteStable(float timeout, bool minimise, bool useSeed = false, const LifeState &seed = LifeState());
+  LifeState MostConstrained(const LifeState &cells) const;
+  std::pair<int, int> ChooseBranchCell(const LifeState &settable) const;
+  std::pair<int, int> ChooseBranchCell(const LifeState &settable, const StableSearchContext &search) const;
+
+  CompletionResult CompleteStableStep(std::chrono::system_clock::time_point &timeLimit, bool minimise, bool useSeed, const LifeState &seed, unsigned &maxPop, LifeState &best, StableSearchContext &search);
+  // Pass a cache to learn conflicts and keep them between calls
+  // (without one nothing is learned), and `nodes` to find out how many branches the search visited
+  std::pair<LifeStable::CompletionResult, LifeState> CompleteStable(float timeout, bool minimise, bool useSeed = false, const LifeState &seed = LifeState(), StableConflictCache *cache = nullptr, BranchHeuristic heuristic = BranchHeuristic::DEFAULT, uint64_t *nodes = nullptr);
+  // Only completions with the given symmetry. Branches on the fundamental
+  // domain and mirrors every decision to the rest of the orbit. `sym`
+  // must be one `CanSymmetricize` accepts, otherwise this is INCONSISTENT.
+  std::pair<LifeStable::CompletionResult, LifeState> CompleteStable(float timeout, bool minimise, StaticSymmetry sym, std::pair<int, int> offset, StableConflictCache *cache = nullptr, uint64_t *nodes = nullptr);
+  std::pair<LifeStable::CompletionResult, LifeState> CompleteStable(float timeout, bool minimise, bool useSeed, const LifeState &seed, StableSearchContext &search);
+
+  // The union of the constraints on every image of each cell, or false if
+  // these contradict or `sym` is not one `CanSymmetricize` accepts
+  bool Symmetricize(StaticSymmetry sym, std::pair<int, int> offset);
   // std::pair<CompletionResult, LifeState> CompleteStable(float timeout, bool minimise);
 
+  // Visit every distinct completion with population at most `maxPop`,
+  // in the order the DFS finds them, stopping after `limit` of them.
+  // Returns INCONSISTENT only if there are no completions at all.
+  using CompletionCallback = std::function<void(const LifeState &)>;
+  CompletionResult EnumerateStableStep(std::chrono::system_clock::time_point &timeLimit, unsigned maxPop, unsigned &remaining, std::unordered_set<uint64_t> &seen, const CompletionCallback &callback);
+  CompletionResult EnumerateStable(float timeout, unsigned maxPop, unsigned limit, const CompletionCallback &callback);
+
   std::string RLE() const;
   std::string RLEWHeader() const {
     return "x = 0, y = 0, rule = LifeBellman\n" + RLE();
@@ -214,7 +255,160 @@ public:
   }
 };
 
-LifeStable LifeStable::Join(const LifeStable &other) const {
+// The neighbour counts used by `UpdateOptions` and `SignalNeighbours`,
+// carried from one step of `Propagate` to the next. Each step changes
+// only a few cells, so only the columns around those are recounted.
+//
+// This is kept out of LifeStable itself, which is copied at every branch
+// of a search.
+struct StableCounts {
+  bool counted = false;
+  LifeState state;   // What the counts were taken from
+  LifeState unknown;
+
+  NeighbourCount stateCount;
+  NeighbourCount offCount; // ~unknown & ~state
+  NeighbourCount maxCount; // state | unknown
+
+  void Update(const LifeStable &stable) {
+    LifeState off = ~stable.unknown & ~stable.state;
+    LifeState max = stable.state | stable.unknown;
+    if (!counted) {
+      stateCount = NeighbourCount(stable.state);
+      offCount = NeighbourCount(off);
+      maxCount = NeighbourCount(max);
+      counted = true;
+    } else {
+      uint64_t dirty = NeighbourCount::DirtyColumns((state ^ stable.state) | (unknown ^ stable.unknown));
+      stateCount.Update(stable.state, dirty);
+      offCount.Update(off, dirty);
+      maxCount.Update(max, dirty);
+    }
+    state = stable.state;
+    unknown = stable.unknown;
+  }
+};
+
+// Local patterns around a branch cell that are known to have no stable
+// completion. Keys are relative to the cell, so a conflict learned in one
+// round of `CompleteStable` prunes the same fragment anywhere in later
+// rounds and later calls.
+struct StableConflictCache {
+  static constexpr unsigned radius = 2;
+  static constexpr unsigned patchBits = (2 * radius + 1) * (2 * radius + 1);
+  static constexpr unsigned searchBudget = 100;
+
+  std::unordered_set<uint64_t> nogoods;
+  std::unordered_set<uint64_t> checked;
+
+  static uint64_t Key(const LifeStable &stable, std::pair<int, int> cell) {
+    uint64_t unknownPatch = stable.unknown.GetPatch<radius>(cell);
+    uint64_t statePatch = stable.state.GetPatch<radius>(cell) & ~unknownPatch;
+    return statePatch | unknownPatch << patchBits;
+  }
+
+  bool IsConflict(uint64_t key) const { return nogoods.contains(key); }
+
+  // Only remembered if the pattern is inconsistent on its own, with
+  // everything outside it unknown, so the cache never prunes a solution.
+  // Called when the subtree below a branch fails.
+  void Learn(uint64_t key);
+
+  // Propagation alone only finds what the search would have found in a
+  // single node, so this also searches the patch itself. Any stable
+  // completion restricts to an assignment of the patch that survives
+  // propagation; if none does, the pattern is a nogood. Running out of
+  // budget counts as consistent.
+  static bool SearchPatch(LifeStable &pattern, unsigned &budget);
+};
+
+// VSIDS-style scores: every conflict bumps the branch cell by an amount
+// that grows geometrically, so older conflicts fade away
+struct BranchActivity {
+  static constexpr float decay = 0.95;
+
+  std::array<float, N * N> score{};
+  float increment = 1;
+
+  float operator[](std::pair<int, int> cell) const { return score[cell.first * N + cell.second]; }
+
+  void Bump(std::pair<int, int> cell) {
+    score[cell.first * N + cell.second] += increment;
+    increment /= decay;
+    if (increment > 1e30) {
+      for (auto &s : score)
+        s *= 1e-30;
+      increment *= 1e-30;
+    }
+  }
+};
+
+struct StableSearchContext {
+  StableConflictCache *cache = nullptr;
+  BranchHeuristic heuristic;
+  LifeState origin;
+  BranchActivity activity{};
+  uint64_t nodes = 0;
+
+  StaticSymmetry symmetry = StaticSymmetry::C1;
+  std::pair<int, int> symmetryOffset = {0, 0};
+  LifeState domain = ~LifeState();
+};
+
+inline void StableConflictCache::Learn(uint64_t key) {
+  if (!checked.insert(key).second)
+    return;
+
+  const std::pair<int, int> centre = {N / 2, N / 2};
+  const uint64_t patchMask = (1ULL << patchBits) - 1;
+
+  LifeState on, known;
+  on.SetPatch<radius>(centre, key & patchMask);
+  known.SetPatch<radius>(centre, ~(key >> patchBits) & patchMask);
+
+  LifeStable pattern;
+  pattern.unknown = ~LifeState();
+  pattern.SetOn(on);
+  pattern.SetOff(known & ~on);
+
+  unsigned budget = searchBudget;
+  if (!SearchPatch(pattern, budget))
+    nogoods.insert(key);
+}
+
+inline bool StableConflictCache::SearchPatch(LifeStable &pattern, unsigned &budget) {
+  const std::pair<int, int> centre = {N / 2, N / 2};
+
+  // Everything outside the patch is unknown, so only the patch and the
+  // ring around it can be forced, and two strips cover that.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (unsigned column : {centre.first - radius, centre.first + radius}) {
+      auto result = pattern.PropagateStrip(column);
+      if (!result.consistent)
+        return false;
+      changed = changed || result.changed;
+    }
+  }
+
+  const LifeState patch = LifeState::SolidRect(centre.first - radius, centre.second - radius,
+                                               2 * radius + 1, 2 * radius + 1);
+  LifeState open = pattern.unknown & patch;
+  if (open.IsEmpty() || budget == 0)
+    return true;
+  budget--;
+
+  std::pair<int, int> cell = pattern.MostConstrained(open).FirstOn();
+  LifeStable off = pattern;
+  off.SetOff(cell);
+  if (SearchPatch(off, budget))
+    return true;
+  pattern.SetOn(cell);
+  return SearchPatch(pattern, budget);
+}
+
+inline LifeStable LifeStable::Join(const LifeStable &other) const {
   LifeStable result;
 
   result.unknown = unknown | other.unknown | (state ^ other.state);
@@ -232,7 +426,7 @@ LifeStable LifeStable::Join(const LifeStable &other) const {
   return result;
 }
 
-LifeStable LifeStable::Graft(const LifeStable &other) const {
+inline LifeStable LifeStable::Graft(const LifeStable &other) const {
   LifeStable result;
 
   result.unknown = unknown & ~(~other.unknown & other.dead0);
@@ -250,7 +444,7 @@ LifeStable LifeStable::Graft(const LifeStable &other) const {
   return result;
 }
 
-LifeStable LifeStable::ClearUnmodified() const {
+inline LifeStable LifeStable::ClearUnmodified() const {
   LifeStable result = *this;
 
   LifeState toClear = unknown & ~(dead0.ZOI());
@@ -263,7 +457,7 @@ LifeStable LifeStable::ClearUnmodified() const {
   return result;
 }
 
-LifeState LifeStable::Differences(const LifeStable &other) const {
+inline LifeState LifeStable::Differences(const LifeStable &other) const {
   LifeState result;
 
   result |= state ^ other.state;
@@ -281,7 +475,7 @@ LifeState LifeStable::Differences(const LifeStable &other) const {
   return result;
 }
 
-StableOptions LifeStable::GetOptions(std::pair<int, int> cell) const {
+inline StableOptions LifeStable::GetOptions(std::pair<int, int> cell) const {
   auto result = StableOptions::IMPOSSIBLE;
   if(!live2.Get(cell)) result |= StableOptions::LIVE2;
   if(!live3.Get(cell)) result |= StableOptions::LIVE3;
@@ -293,7 +487,7 @@ StableOptions LifeStable::GetOptions(std::pair<int, int> cell) const {
   if(!dead6.Get(cell)) result |= StableOptions::DEAD6;
   return result;
 }
-void LifeStable::RestrictOptions(std::pair<int, int> cell,
+inline void LifeStable::RestrictOptions(std::pair<int, int> cell,
                                       StableOptions options) {
   if ((options & StableOptions::LIVE2) != StableOptions::LIVE2) live2.Set(cell);
   if ((options & StableOptions::LIVE3) != StableOptions::LIVE3) live3.Set(cell);
@@ -305,7 +499,7 @@ void LifeStable::RestrictOptions(std::pair<int, int> cell,
   if ((options & StableOptions::DEAD6) != StableOptions::DEAD6) dead6.Set(cell);
 }
 
-void LifeStable::RestrictOptions(LifeState cells,
+inline void LifeStable::RestrictOptions(LifeState cells,
                                       StableOptions options) {
   if ((options & StableOptions::LIVE2) != StableOptions::LIVE2) live2 |= cells;
   if ((options & StableOptions::LIVE3) != StableOptions::LIVE3) live3 |= cells;
@@ -317,7 +511,7 @@ void LifeStable::RestrictOptions(LifeState cells,
   if ((options & StableOptions::DEAD6) != StableOptions::DEAD6) dead6 |= cells;
 }
 
-void LifeStable::SetOn(const LifeState &which) {
+inline void LifeStable::SetOn(const LifeState &which) {
   state |= which;
   unknown &= ~which;
   dead0 |= which;
@@ -327,14 +521,14 @@ void LifeStable::SetOn(const LifeState &which) {
   dead5 |= which;
   dead6 |= which;
 }
-void LifeStable::SetOff(const LifeState &which) {
+inline void LifeStable::SetOff(const LifeState &which) {
   state &= ~which;
   unknown &= ~which;
   live2 |= which;
   live3 |= which;
 }
 
-void LifeStable::SetOn(unsigned i, uint64_t which) {
+inline void LifeStable::SetOn(unsigned i, uint64_t which) {
   state[i] |= which;
   unknown[i] &= ~which;
   dead0[i] |= which;
@@ -344,26 +538,26 @@ void LifeStable::SetOn(unsigned i, uint64_t which) {
   dead5[i] |= which;
   dead6[i] |= which;
 }
-void LifeStable::SetOff(unsigned i, uint64_t which) {
+inline void LifeStable::SetOff(unsigned i, uint64_t which) {
   state[i] &= ~which;
   unknown[i] &= ~which;
   live2[i] |= which;
   live3[i] |= which;
 }
 
-void LifeStable::SetOn(std::pair<int, int> cell) {
+inline void LifeStable::SetOn(std::pair<int, int> cell) {
   state.Set(cell);
   unknown.Erase(cell);
   RestrictOptions(cell, StableOptions::LIVE);
 }
 
-void LifeStable::SetOff(std::pair<int, int> cell) {
+inline void LifeStable::SetOff(std::pair<int, int> cell) {
   state.Erase(cell);
   unknown.Erase(cell);
   RestrictOptions(cell, StableOptions::DEAD);
 }
 
-LifeState LifeStable::Vulnerable() const {
+inline LifeState LifeStable::Vulnerable() const {
   NeighbourCount stateCount(state);
   NeighbourCount unknownCount(unknown);
 
@@ -411,7 +605,7 @@ LifeState LifeStable::Vulnerable() const {
   return on & off;
 }
 
-LifeStable::PropagateResult LifeStable::PropagateSimpleStep() {
+inline LifeStable::PropagateResult LifeStable::PropagateSimpleStep() {
   LifeState startUnknown = unknown;
 
   NeighbourCount stateCount(state);
@@ -502,7 +696,7 @@ LifeStable::PropagateResult LifeStable::PropagateSimpleStep() {
   return {true, unknown != startUnknown};
 }
 
-LifeStable::PropagateResult LifeStable::PropagateSimple() {
+inline LifeStable::PropagateResult LifeStable::PropagateSimple() {
   bool done = false;
   bool changed = false;
   while (!done) {
@@ -523,7 +717,7 @@ LifeStable::PropagateResult LifeStable::PropagateSimple() {
   return {true, changed};
 }
 
-LifeStable::PropagateResult LifeStable::SynchroniseStateKnown() {
+inline LifeStable::PropagateResult LifeStable::SynchroniseStateKnown() {
   LifeState changes;
 
   LifeState knownOn = ~unknown & state;
@@ -555,10 +749,12 @@ LifeStable::PropagateResult LifeStable::SynchroniseStateKnown() {
   return {true, !changes.IsEmpty()};
 }
 
-LifeStable::PropagateResult LifeStable::UpdateOptions() {
-  NeighbourCount stateCount(state);
-  NeighbourCount offCount(~unknown & ~state);
+inline LifeStable::PropagateResult LifeStable::UpdateOptions() {
+  return UpdateOptions(NeighbourCount(state), NeighbourCount(~unknown & ~state));
+}
 
+inline LifeStable::PropagateResult LifeStable::UpdateOptions(const NeighbourCount &stateCount,
+                                                             const NeighbourCount &offCount) {
   uint64_t has_abort = 0;
   uint64_t changes = 0;
 
@@ -614,10 +810,12 @@ LifeStable::PropagateResult LifeStable::UpdateOptions() {
   return {has_abort == 0, changes != 0};
 }
 
-LifeStable::PropagateResult LifeStable::SignalNeighbours() {
-  NeighbourCount stateCount(state);
-  NeighbourCount maxCount(state | unknown);
+inline LifeStable::PropagateResult LifeStable::SignalNeighbours() {
+  return SignalNeighbours(NeighbourCount(state), NeighbourCount(state | unknown));
+}
 
+inline LifeStable::PropagateResult LifeStable::SignalNeighbours(const NeighbourCount &stateCount,
+                                                                const NeighbourCount &maxCount) {
   LifeState new_signal_off(InitializedTag::UNINITIALIZED), new_signal_on(InitializedTag::UNINITIALIZED);
   LifeState new_center_off(InitializedTag::UNINITIALIZED), new_center_on(InitializedTag::UNINITIALIZED);
 
@@ -674,7 +872,12 @@ LifeStable::PropagateResult LifeStable::SignalNeighbours() {
   return {true, !changes.IsEmpty()};
 }
 
-LifeStable::PropagateResult LifeStable::StabiliseOptions() {
+inline LifeStable::PropagateResult LifeStable::StabiliseOptions() {
+  StableCounts counts;
+  return StabiliseOptions(counts);
+}
+
+inline LifeStable::PropagateResult LifeStable::StabiliseOptions(StableCounts &counts) {
   bool changedEver = false;
   bool done = false;
   while (!done) {
@@ -682,7 +885,8 @@ LifeStable::PropagateResult LifeStable::StabiliseOptions() {
     if (!knownresult.consistent)
       return {false, false};
 
-    PropagateResult optionsresult = UpdateOptions();
+    counts.Update(*this);
+    PropagateResult optionsresult = UpdateOptions(counts.stateCount, counts.offCount);
     if (!optionsresult.consistent)
       return {false, false};
 
@@ -692,16 +896,24 @@ LifeStable::PropagateResult LifeStable::StabiliseOptions() {
   return {true, changedEver};
 }
 
-LifeStable::PropagateResult LifeStable::PropagateStep() {
+inline LifeStable::PropagateResult LifeStable::PropagateStep() {
+  StableCounts counts;
+  return PropagateStep(counts);
+}
+
+inline LifeStable::PropagateResult LifeStable::PropagateStep(StableCounts &counts) {
   PropagateResult knownresult = SynchroniseStateKnown();
   if (!knownresult.consistent)
     return {false, false};
 
-  PropagateResult optionsresult = UpdateOptions();
+  // `UpdateOptions` only touches the options, so the counts stay good for
+  // `SignalNeighbours` too
+  counts.Update(*this);
+  PropagateResult optionsresult = UpdateOptions(counts.stateCount, counts.offCount);
   if (!optionsresult.consistent)
     return {false, false};
 
-  PropagateResult signalresult = SignalNeighbours();
+  PropagateResult signalresult = SignalNeighbours(counts.stateCount, counts.maxCount);
   if (!signalresult.consistent)
     return {false, false};
 
@@ -715,11 +927,12 @@ LifeStable::PropagateResult LifeStable::PropagateStep() {
   return {true, changed};
 }
 
-LifeStable::PropagateResult LifeStable::Propagate() {
+inline LifeStable::PropagateResult LifeStable::Propagate() {
+  StableCounts counts;
   bool changedEver = false;
   bool done = false;
   while (!done) {
-    PropagateResult result = PropagateStep();
+    PropagateResult result = PropagateStep(counts);
     if (!result.consistent)
       return {false, false};
     done = !result.changed;
@@ -770,7 +983,7 @@ void inline CountNeighbourhoodStrip(
   }
 }
 
-LifeStable::PropagateResult LifeStable::PropagateSimpleStepStrip(unsigned column) {
+inline LifeStable::PropagateResult LifeStable::PropagateSimpleStepStrip(unsigned column) {
   std::array<uint64_t, 6> nearbyState = state.GetStrip<6>(column);
   std::array<uint64_t, 6> nearbyUnknown = unknown.GetStrip<6>(column);
 
@@ -889,7 +1102,7 @@ LifeStable::PropagateResult LifeStable::PropagateSimpleStepStrip(unsigned column
 }
 
 
-std::pair<uint64_t, uint64_t> LifeStable::SynchroniseStateKnownColumn(unsigned i) {
+inline std::pair<uint64_t, uint64_t> LifeStable::SynchroniseStateKnownColumn(unsigned i) {
   uint64_t changes = 0;
 
   uint64_t knownOn = ~unknown[i] & state[i];
@@ -918,7 +1131,7 @@ std::pair<uint64_t, uint64_t> LifeStable::SynchroniseStateKnownColumn(unsigned i
   return {abort, changes};
 }
 
-LifeStable::PropagateResult LifeStable::SynchroniseStateKnownStrip(unsigned column) {
+inline LifeStable::PropagateResult LifeStable::SynchroniseStateKnownStrip(unsigned column) {
   const unsigned width = 6;
   const unsigned offset = (width - 1) / 2; // 0, 0, 1, 1, 2, 2
   if (offset <= column && column + width - 1 - offset < N) {
@@ -947,7 +1160,7 @@ LifeStable::PropagateResult LifeStable::SynchroniseStateKnownStrip(unsigned colu
   }
 }
 
-LifeStable::PropagateResult LifeStable::SynchroniseStateKnown(std::pair<int, int> cell) {
+inline LifeStable::PropagateResult LifeStable::SynchroniseStateKnown(std::pair<int, int> cell) {
   bool knownOn = !unknown.Get(cell) && state.Get(cell);
   if(knownOn) {
     dead0.Set(cell);
@@ -971,7 +1184,7 @@ LifeStable::PropagateResult LifeStable::SynchroniseStateKnown(std::pair<int, int
   return {true, false};
 }
 
-LifeStable::PropagateResult LifeStable::PropagateSimpleStrip(unsigned column) {
+inline LifeStable::PropagateResult LifeStable::PropagateSimpleStrip(unsigned column) {
   bool done = false;
   bool changed = false;
   while (!done) {
@@ -992,7 +1205,7 @@ LifeStable::PropagateResult LifeStable::PropagateSimpleStrip(unsigned column) {
   return {true, changed};
 }
 
-LifeStable::PropagateResult LifeStable::SignalNeighboursStrip(unsigned column) {
+inline LifeStable::PropagateResult LifeStable::SignalNeighboursStrip(unsigned column) {
   std::array<uint64_t, 6> nearbyState = state.GetStrip<6>(column);
   std::array<uint64_t, 6> nearbyUnknown = unknown.GetStrip<6>(column);
   std::array<uint64_t, 6> nearbyMax;
@@ -1108,7 +1321,7 @@ LifeStable::PropagateResult LifeStable::SignalNeighboursStrip(unsigned column) {
   return {true, unknownChanges != 0};
 }
 
-LifeStable::PropagateResult LifeStable::UpdateOptionsStrip(unsigned column) {
+inline LifeStable::PropagateResult LifeStable::UpdateOptionsStrip(unsigned column) {
   std::array<uint64_t, 6> nearbyState = state.GetStrip<6>(column);
   std::array<uint64_t, 6> nearbyUnknown = unknown.GetStrip<6>(column);
   std::array<uint64_t, 6> nearbyOff;
@@ -1194,7 +1407,7 @@ LifeStable::PropagateResult LifeStable::UpdateOptionsStrip(unsigned column) {
   return {has_abort == 0, changes != 0};
 }
 
-LifeStable::PropagateResult LifeStable::StabiliseOptionsStrip(unsigned column) {
+inline LifeStable::PropagateResult LifeStable::StabiliseOptionsStrip(unsigned column) {
   bool changedEver = false;
   bool done = false;
   while (!done) {
@@ -1212,7 +1425,7 @@ LifeStable::PropagateResult LifeStable::StabiliseOptionsStrip(unsigned column) {
   return {true, changedEver};
 }
 
-LifeStable::PropagateResult LifeStable::PropagateStepStrip(unsigned column) {
+inline LifeStable::PropagateResult LifeStable::PropagateStepStrip(unsigned column) {
   PropagateResult knownresult = SynchroniseStateKnownStrip(column);
   if (!knownresult.consistent)
     return {false, false};
@@ -1235,7 +1448,7 @@ LifeStable::PropagateResult LifeStable::PropagateStepStrip(unsigned column) {
   return {true, changed};
 }
 
-LifeStable::PropagateResult LifeStable::PropagateStrip(unsigned column) {
+inline LifeStable::PropagateResult LifeStable::PropagateStrip(unsigned column) {
   bool changedEver = false;
   bool done = false;
   while (!done) {
@@ -1248,7 +1461,7 @@ LifeStable::PropagateResult LifeStable::PropagateStrip(unsigned column) {
   return {true, changedEver};
 }
 
-LifeStable::PropagateResult LifeStable::TestUnknown(std::pair<int, int> cell) {
+inline LifeStable::PropagateResult LifeStable::TestUnknown(std::pair<int, int> cell) {
   // Try on
   LifeStable onSearch = *this;
   onSearch.SetOn(cell);
@@ -1318,32 +1531,101 @@ LifeStable::PropagateResult LifeStable::TestUnknown(std::pair<int, int> cell) {
 //   return {true, false}; // Impossible
 // }
 
-LifeStable::PropagateResult LifeStable::TestUnknowns(const LifeState &cells) {
+inline LifeStable::PropagateResult LifeStable::TestUnknowns(const LifeState &cells) {
   // Try all the nearby changes to see if any are forced
-  LifeState remainingCells = cells & unknown;
   bool anyChanges = false;
-  while (!remainingCells.IsEmpty()) {
-    auto cell = remainingCells.FirstOn();
-    remainingCells.Erase(cell);
+  for (auto cell : (cells & unknown).Cells()) {
+    // Earlier tests may have settled it already
+    if (!unknown.Get(cell))
+      continue;
 
     auto result = TestUnknown(cell);
     if (!result.consistent)
       return {false, false};
     anyChanges = anyChanges || result.changed;
-
-    remainingCells &= unknown;
   }
 
   return {true, anyChanges};
 }
 
-LifeStable::CompletionResult LifeStable::CompleteStableStep(
+inline LifeState LifeStable::MostConstrained(const LifeState &cells) const {
+  // Bit-sliced count of the ruled out options
+  LifeState bit0, bit1, bit2, bit3;
+  for (const LifeState *plane : {&live2, &live3, &dead0, &dead1, &dead2, &dead4, &dead5, &dead6}) {
+    LifeState carry0 = bit0 & *plane;
+    bit0 ^= *plane;
+    LifeState carry1 = bit1 & carry0;
+    bit1 ^= carry0;
+    LifeState carry2 = bit2 & carry1;
+    bit2 ^= carry1;
+    bit3 |= carry2;
+  }
+
+  LifeState result = cells;
+  for (const LifeState *bit : {&bit3, &bit2, &bit1, &bit0}) {
+    LifeState narrowed = result & *bit;
+    if (!narrowed.IsEmpty())
+      result = narrowed;
+  }
+  return result;
+}
+
+inline std::pair<int, int> LifeStable::ChooseBranchCell(const LifeState &settable, const StableSearchContext &search) const {
+  switch (search.heuristic) {
+  case BranchHeuristic::MOST_CONSTRAINED:
+    return ChooseBranchCell(MostConstrained(settable));
+
+  case BranchHeuristic::ACTIVITY: {
+    std::pair<int, int> best = {-1, -1};
+    float bestScore = 0;
+    for (int i = 0; i < N; i++) {
+      uint64_t column = settable[i];
+      while (column) {
+        int j = std::countr_zero(column);
+        column &= column - 1;
+        float score = search.activity[{i, j}];
+        if (score > bestScore) {
+          best = {i, j};
+          bestScore = score;
+        }
+      }
+    }
+    if (best.first != -1)
+      return best;
+    return ChooseBranchCell(settable);
+  }
+
+  default:
+    return ChooseBranchCell(settable);
+  }
+}
+
+inline std::pair<int, int> LifeStable::ChooseBranchCell(const LifeState &settable) const {
+  std::pair<int, int> newPlacement = (Vulnerable() & settable).FirstOn();
+
+  if (newPlacement.first == -1) {
+    NeighbourCount unknownCount(unknown);
+
+    newPlacement = (settable & (~unknownCount.bit3 & ~unknownCount.bit2 & unknownCount.bit1 & ~unknownCount.bit0)).FirstOn();
+    if(newPlacement.first == -1)
+      newPlacement = (settable & (~unknownCount.bit3 & ~unknownCount.bit2 & unknownCount.bit1 & unknownCount.bit0)).FirstOn();
+    if(newPlacement.first == -1)
+      newPlacement = settable.FirstOn();
+  }
+
+  return newPlacement;
+}
+
+inline LifeStable::CompletionResult LifeStable::CompleteStableStep(
     std::chrono::system_clock::time_point &timeLimit, bool minimise,
-    bool useSeed, const LifeState &seed, unsigned &maxPop, LifeState &best) {
+    bool useSeed, const LifeState &seed, unsigned &maxPop, LifeState &best,
+    StableSearchContext &search) {
   auto currentTime = std::chrono::system_clock::now();
   if (currentTime > timeLimit)
       return CompletionResult::TIMEOUT;
 
+  search.nodes++;
+
   bool consistent = Propagate().consistent;
   if (!consistent)
     return CompletionResult::INCONSISTENT;
@@ -1363,9 +1645,9 @@ LifeStable::CompletionResult LifeStable::CompleteStableStep(
     return CompletionResult::COMPLETED;
   }
 
-  if(useSeed) {
+  if(useSeed || search.heuristic == BranchHeuristic::SEED_DISTANCE) {
     // Prefer cells close to the seed
-    LifeState seedZOI = seed;
+    LifeState seedZOI = useSeed ? seed : search.origin;
     while (true) {
       if (!(settable & seedZOI).IsEmpty())
         break;
@@ -1375,43 +1657,68 @@ LifeStable::CompletionResult LifeStable::CompleteStableStep(
   }
 
   // Now make a guess for the best cell to branch on
-  std::pair<int, int> newPlacement = {-1, -1};
-  newPlacement = (Vulnerable() & settable).FirstOn();
+  if (search.symmetry != StaticSymmetry::C1) {
+    // Everything outside the domain is decided by its image inside
+    LifeState inDomain = settable & search.domain;
+    if (!inDomain.IsEmpty())
+      settable = inDomain;
+  }
 
-  if (newPlacement.first == -1) {
-    NeighbourCount unknownCount(unknown);
+  std::pair<int, int> newPlacement = ChooseBranchCell(settable, search);
+  if (newPlacement.first == -1)
+    return CompletionResult::INCONSISTENT;
 
-    newPlacement = (settable & (~unknownCount.bit3 & ~unknownCount.bit2 & unknownCount.bit1 & ~unknownCount.bit0)).FirstOn();
-    if(newPlacement.first == -1)
-      newPlacement = (settable & (~unknownCount.bit3 & ~unknownCount.bit2 & unknownCount.bit1 & unknownCount.bit0)).FirstOn();
-    if(newPlacement.first == -1)
-      newPlacement = settable.FirstOn();
-    if(newPlacement.first == -1)
-      return CompletionResult::INCONSISTENT;
-  }
+  StableConflictCache *cache = search.cache;
+
+  LifeState orbit;
+  if (search.symmetry != StaticSymmetry::C1)
+    orbit = ::Symmetricize(LifeState::Cell(newPlacement), search.symmetry, search.symmetryOffset);
 
   // Try off
   {
     LifeStable nextState = *this;
-    nextState.SetOff(newPlacement);
-    auto result = nextState.CompleteStableStep(timeLimit, minimise, useSeed, seed, maxPop, best);
-    if (result == CompletionResult::TIMEOUT)
-      return CompletionResult::TIMEOUT;
-    if (!minimise && result == CompletionResult::COMPLETED)
-      return CompletionResult::COMPLETED;
+    if (search.symmetry == StaticSymmetry::C1)
+      nextState.SetOff(newPlacement);
+    else
+      nextState.SetOff(orbit);
+    uint64_t key = StableConflictCache::Key(nextState, newPlacement);
+    if (cache == nullptr || !cache->IsConflict(key)) {
+      auto result = nextState.CompleteStableStep(timeLimit, minimise, useSeed, seed, maxPop, best, search);
+      if (result == CompletionResult::TIMEOUT)
+        return CompletionResult::TIMEOUT;
+      if (!minimise && result == CompletionResult::COMPLETED)
+        return CompletionResult::COMPLETED;
+      if (result == CompletionResult::INCONSISTENT) {
+        if (cache != nullptr)
+          cache->Learn(key);
+        search.activity.Bump(newPlacement);
+      }
+    } else {
+      search.activity.Bump(newPlacement);
+    }
   }
 
   // Then must be on
   {
     LifeStable &nextState = *this;
-    nextState.SetOn(newPlacement);
+    if (search.symmetry == StaticSymmetry::C1)
+      nextState.SetOn(newPlacement);
+    else
+      nextState.SetOn(orbit);
+    if (cache != nullptr && cache->IsConflict(StableConflictCache::Key(nextState, newPlacement))) {
+      search.activity.Bump(newPlacement);
+      return CompletionResult::INCONSISTENT;
+    }
 
     [[clang::musttail]]
-    return nextState.CompleteStableStep(timeLimit, minimise, useSeed, seed, maxPop, best);
+    return nextState.CompleteStableStep(timeLimit, minimise, useSeed, seed, maxPop, best, search);
   }
 }
 
-std::pair<LifeStable::CompletionResult, LifeState> LifeStable::CompleteStable(float timeout, bool minimise, bool useSeed, const LifeState &seed) {
+inline std::pair<LifeStable::CompletionResult, LifeState> LifeStable::CompleteStable(float timeout, bool minimise, bool useSeed, const LifeState &seed, StableConflictCache *cache, BranchHeuristic heuristic, uint64_t *nodes) {
+  if (nodes != nullptr)
+    *nodes = 0;
+
   if (state.IsEmpty()) {
     return {CompletionResult::COMPLETED, LifeState()};
   }
@@ -1419,6 +1726,66 @@ std::pair<LifeStable::CompletionResult, LifeState> LifeStable::CompleteStable(fl
     return {CompletionResult::COMPLETED, state};
   }
 
+  StableSearchContext search = {.cache = cache, .heuristic = heuristic, .origin = state};
+  auto result = CompleteStable(timeout, minimise, useSeed, seed, search);
+
+  if (nodes != nullptr)
+    *nodes = search.nodes;
+  return result;
+}
+
+inline std::pair<LifeStable::CompletionResult, LifeState>
+LifeStable::CompleteStable(float timeout, bool minimise, StaticSymmetry sym,
+                           std::pair<int, int> offset,
+                           StableConflictCache *cache, uint64_t *nodes) {
+  if (nodes != nullptr)
+    *nodes = 0;
+
+  if (!CanSymmetricize(sym))
+    return {CompletionResult::INCONSISTENT, LifeState()};
+
+  LifeStable symmetric = *this;
+  if (!symmetric.Symmetricize(sym, offset))
+    return {CompletionResult::INCONSISTENT, LifeState()};
+
+  if (symmetric.state.IsEmpty())
+    return {CompletionResult::COMPLETED, LifeState()};
+  if (symmetric.unknown.IsEmpty())
+    return {CompletionResult::COMPLETED, symmetric.state};
+
+  StableSearchContext search = {.cache = cache, .heuristic = BranchHeuristic::DEFAULT, .origin = symmetric.state};
+  search.symmetry = sym;
+  search.symmetryOffset = offset;
+  search.domain = FundamentalDomain(sym);
+  search.domain.Move(HalveOffset(sym, offset));
+
+  auto result = symmetric.CompleteStable(timeout, minimise, false, LifeState(), search);
+
+  if (nodes != nullptr)
+    *nodes = search.nodes;
+  return result;
+}
+
+inline bool LifeStable::Symmetricize(StaticSymmetry sym, std::pair<int, int> offset) {
+  if (!CanSymmetricize(sym))
+    return false;
+
+  LifeState knownOn = ::Symmetricize(~unknown & state, sym, offset);
+  LifeState knownOff = ::Symmetricize(~unknown & ~state, sym, offset);
+  if (!(knownOn & knownOff).IsEmpty())
+    return false;
+
+  for (LifeState *plane : {&live2, &live3, &dead0, &dead1, &dead2, &dead4, &dead5, &dead6})
+    *plane = ::Symmetricize(*plane, sym, offset);
+
+  SetOn(knownOn);
+  SetOff(knownOff);
+  return true;
+}
+
+inline std::pair<LifeStable::CompletionResult, LifeState>
+LifeStable::CompleteStable(float timeout, bool minimise, bool useSeed,
+                           const LifeState &seed, StableSearchContext &search) {
   LifeState best;
   unsigned maxPop = std::numeric_limits<int>::max();
 
@@ -1434,7 +1801,7 @@ std::pair<LifeStable::CompletionResult, LifeState> LifeStable::CompleteStable(fl
 
     LifeStable copy = *this;
     copy.unknown &= searchArea;
-    result = copy.CompleteStableStep(timeLimit, minimise, useSeed, seed, maxPop, best);
+    result = copy.CompleteStableStep(timeLimit, minimise, useSeed, seed, maxPop, best, search);
 
     auto currentTime = std::chrono::system_clock::now();
     if (best.GetPop() > 0 || currentTime > timeLimit)
@@ -1451,21 +1818,89 @@ std::pair<LifeStable::CompletionResult, LifeState> LifeStable::CompleteStable(fl
     // Then try again with a little more space
     LifeStable copy = *this;
     copy.unknown &= searchArea.BigZOI();
-    copy.CompleteStableStep(timeLimit, minimise, true, state | best, maxPop, best);
+    copy.CompleteStableStep(timeLimit, minimise, true, state | best, maxPop, best, search);
   }
 
   return {CompletionResult::COMPLETED, best};
 }
 
+inline LifeStable::CompletionResult LifeStable::EnumerateStableStep(
+    std::chrono::system_clock::time_point &timeLimit, unsigned maxPop,
+    unsigned &remaining, std::unordered_set<uint64_t> &seen,
+    const CompletionCallback &callback) {
+  auto currentTime = std::chrono::system_clock::now();
+  if (currentTime > timeLimit)
+      return CompletionResult::TIMEOUT;
+
+  bool consistent = Propagate().consistent;
+  if (!consistent)
+    return CompletionResult::INCONSISTENT;
+
+  // The population only grows as we go deeper
+  if (state.GetPop() > maxPop)
+    return CompletionResult::INCONSISTENT;
+
+  LifeState settable = PerturbedUnknowns() & dead0.ZOI();
+
+  if (settable.IsEmpty()) {
+    if (seen.insert(state.GetHash()).second) {
+      callback(state);
+      remaining--;
+    }
+    return CompletionResult::COMPLETED;
+  }
+
+  std::pair<int, int> newPlacement = ChooseBranchCell(settable);
+  if (newPlacement.first == -1)
+    return CompletionResult::INCONSISTENT;
+
+  CompletionResult offResult;
+
+  // Try off
+  {
+    LifeStable nextState = *this;
+    nextState.SetOff(newPlacement);
+    offResult = nextState.EnumerateStableStep(timeLimit, maxPop, remaining, seen, callback);
+    if (offResult == CompletionResult::TIMEOUT)
+      return CompletionResult::TIMEOUT;
+    if (remaining == 0)
+      return CompletionResult::COMPLETED;
+  }
+
+  // Then on
+  SetOn(newPlacement);
+  CompletionResult onResult = EnumerateStableStep(timeLimit, maxPop, remaining, seen, callback);
+  if (onResult == CompletionResult::TIMEOUT)
+    return CompletionResult::TIMEOUT;
+
+  if (offResult == CompletionResult::COMPLETED)
+    return CompletionResult::COMPLETED;
+  return onResult;
+}
+
+inline LifeStable::CompletionResult LifeStable::EnumerateStable(float timeout, unsigned maxPop, unsigned limit, const CompletionCallback &callback) {
+  if (limit == 0)
+    return CompletionResult::COMPLETED;
+
+  auto startTime = std::chrono::system_clock::now();
+  auto timeLimit = startTime + std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::duration<float>(timeout));
+
+  // Unlike `CompleteStable` there is no point growing the search area
+  // gradually: every round would revisit the completions of the last.
+  LifeStable copy = *this;
+  unsigned remaining = limit;
+  std::unordered_set<uint64_t> seen;
+  return copy.EnumerateStableStep(timeLimit, maxPop, remaining, seen, callback);
+}
 
-bool LifeStable::CompatibleWith(const LifeState &desired) const {
+inline bool LifeStable::CompatibleWith(const LifeState &desired) const {
   LifeStable desiredStable = LifeStable();
   desiredStable.state = desired;
   desiredStable.StabiliseOptions();
   return CompatibleWith(desiredStable);
 }
 
-bool LifeStable::CompatibleWith(const LifeStable &desired) const {
+inline bool LifeStable::CompatibleWith(const LifeStable &desired) const {
   if(!(live2 & ~desired.live2).IsEmpty()) return false;
   if(!(live3 & ~desired.live3).IsEmpty()) return false;
   if(!(dead0 & ~desired.dead0).IsEmpty()) return false;
@@ -1478,7 +1913,7 @@ bool LifeStable::CompatibleWith(const LifeStable &desired) const {
   return true;
 }
 
-std::string LifeStable::RLE() const {
+inline std::string LifeStable::RLE() const {
   LifeState marked = unknown | state;
   return GenericRLE([&](int x, int y) -> char {
     const std::array<char, 4> table = {'.', 'A', 'E', 'C'};
@@ -1,118 +1,201 @@
 #pragma once
 
+#include <ostream>
+
 #include "LifeAPI.hpp"
 
 struct StripIndex {
   unsigned index;
 };
 
-// TODO: template the width
-struct LifeStateStrip {
-  uint64_t state[4];
+// W consecutive columns of a LifeState, starting anywhere and wrapping
+// round the torus. With W = 4 or 8 this is one or two vector registers,
+// so a probe around a few cells can be run without touching a whole
+// LifeState.
+//
+// Cells to the left and right of the strip count as dead, so after
+// stepping n times only the columns at least n in from each edge match
+// what the full LifeState would do. Rows wrap as usual.
+template <unsigned W = 4>
+struct alignas(std::bit_floor(std::min(W * 8, 64u))) LifeStateStrip {
+  static_assert(W >= 1 && W <= N);
+
+  uint64_t state[W];
 
   LifeStateStrip() : state{0} {}
-  LifeStateStrip(const LifeStateStripProxy &proxy);
+  explicit LifeStateStrip(__attribute__((unused)) InitializedTag) {}
+
+  // Columns `column.index` to `column.index + W - 1` of `source`
+  LifeStateStrip(const LifeState &source, StripIndex column) {
+    for (unsigned i = 0; i < W; i++)
+      state[i] = source[torus_wrap(column.index + i)];
+  }
+
+  // Writes the strip back over the same columns
+  void Store(LifeState &dest, StripIndex column) const {
+    for (unsigned i = 0; i < W; i++)
+      dest[torus_wrap(column.index + i)] = state[i];
+  }
 
   uint64_t &operator[](const unsigned i) { return state[i]; }
   uint64_t operator[](const unsigned i) const { return state[i]; }
 
+  bool operator==(const LifeStateStrip &other) const {
+    uint64_t diffs = 0;
+    for (unsigned i = 0; i < W; i++)
+      diffs |= state[i] ^ other[i];
+    return diffs == 0;
+  }
+
   LifeStateStrip operator~() const {
-    LifeStateStrip result;
-    for (unsigned i = 0; i < 4; i++) {
+    LifeStateStrip result(InitializedTag::UNINITIALIZED);
+    for (unsigned i = 0; i < W; i++)
       result[i] = ~state[i];
-    }
     return result;
   }
 
   LifeStateStrip operator|(const LifeStateStrip &other) const {
-    LifeStateStrip result;
-    for (unsigned i = 0; i < 4; i++) {
+    LifeStateStrip result(InitializedTag::UNINITIALIZED);
+    for (unsigned i = 0; i < W; i++)
       result[i] = state[i] | other[i];
-    }
     return result;
   }
 
   LifeStateStrip operator&(const LifeStateStrip &other) const {
-    LifeStateStrip result;
-    for (unsigned i = 0; i < 4; i++) {
+    LifeStateStrip result(InitializedTag::UNINITIALIZED);
+    for (unsigned i = 0; i < W; i++)
       result[i] = state[i] & other[i];
-    }
     return result;
   }
 
   LifeStateStrip operator^(const LifeStateStrip &other) const {
-    LifeStateStrip result;
-    for (unsigned i = 0; i < 4; i++) {
+    LifeStateStrip result(InitializedTag::UNINITIALIZED);
+    for (unsigned i = 0; i < W; i++)
       result[i] = state[i] ^ other[i];
-    }
     return result;
   }
 
+  LifeStateStrip &operator|=(const LifeStateStrip &other) {
+    for (unsigned i = 0; i < W; i++)
+      state[i] |= other[i];
+    return *this;
+  }
+
+  LifeStateStrip &operator&=(const LifeStateStrip &other) {
+    for (unsigned i = 0; i < W; i++)
+      state[i] &= other[i];
+    return *this;
+  }
+
+  LifeStateStrip &operator^=(const LifeStateStrip &other) {
+    for (unsigned i = 0; i < W; i++)
+      state[i] ^= other[i];
+    return *this;
+  }
+
   bool IsEmpty() const {
     uint64_t all = 0;
-    for (unsigned i = 0; i < 4; i++) {
+    for (unsigned i = 0; i < W; i++)
       all |= state[i];
-    }
-
     return all == 0;
   }
 
-  inline friend std::ostream &operator<<(std::ostream &os,
-                                         LifeStateStrip const &self);
-};
+  unsigned GetPop() const {
+    unsigned pop = 0;
+    for (unsigned i = 0; i < W; i++)
+      pop += std::popcount(state[i]);
+    return pop;
+  }
 
-struct LifeStateStripProxy {
-  LifeState *state;
-  StripIndex index;
+  // As `LifeState::CountRows`, with a dead column either side
+  void CountRows(uint64_t (&col0)[W + 2], uint64_t (&col1)[W + 2]) const {
+    col0[0] = col1[0] = 0;
+    col0[W + 1] = col1[W + 1] = 0;
+    for (unsigned i = 0; i < W; i++) {
+      uint64_t a = state[i];
+      uint64_t l = std::rotl(a, 1);
+      uint64_t r = std::rotr(a, 1);
+
+      col0[i + 1] = l ^ r ^ a;
+      col1[i + 1] = ((l ^ r) & a) | (l & r);
+    }
+  }
 
-  LifeStateStripProxy &operator=(const LifeStateStrip &strip) {
-    for (unsigned i = 0; i < 4; i++) {
-      state->state[index.index + i] = strip[i];
+  // Including the cell itself, as `LifeState::CountNeighbourhood`
+  void CountNeighbourhood(LifeStateStrip &bit3, LifeStateStrip &bit2,
+                          LifeStateStrip &bit1, LifeStateStrip &bit0) const {
+    uint64_t col0[W + 2];
+    uint64_t col1[W + 2];
+    CountRows(col0, col1);
+
+    for (unsigned i = 0; i < W; i++) {
+      uint64_t uc0, uc1, uc2, uc_carry0;
+      LifeState::HalfAdd(uc0, uc_carry0, col0[i], col0[i + 1]);
+      LifeState::FullAdd(uc1, uc2, col1[i], col1[i + 1], uc_carry0);
+
+      uint64_t on_carry1, on_carry0;
+      LifeState::HalfAdd(bit0[i], on_carry0, uc0, col0[i + 2]);
+      LifeState::FullAdd(bit1[i], on_carry1, uc1, col1[i + 2], on_carry0);
+      LifeState::HalfAdd(bit2[i], bit3[i], uc2, on_carry1);
     }
-    return *this;
   }
 
-  uint64_t& operator[](const unsigned i) { return state->state[index.index + i]; }
-  uint64_t operator[](const unsigned i) const { return state->state[index.index + i]; }
+  void Step() {
+    uint64_t col0[W + 2];
+    uint64_t col1[W + 2];
+    CountRows(col0, col1);
 
-  LifeStateStrip operator~() const { return ~LifeStateStrip(*this); }
-  LifeStateStrip operator|(LifeStateStripProxy proxy) const { return LifeStateStrip(*this) | LifeStateStrip(proxy); }
-  LifeStateStrip operator&(LifeStateStripProxy proxy) const { return LifeStateStrip(*this) & LifeStateStrip(proxy); }
-  LifeStateStrip operator^(LifeStateStripProxy proxy) const { return LifeStateStrip(*this) ^ LifeStateStrip(proxy); }
-  LifeStateStripProxy &operator|=(LifeStateStrip strip){
-  for (unsigned i = 0; i < 4; i++) {
-    state->state[index.index + i] |= strip[i];
+    for (unsigned i = 0; i < W; i++)
+      state[i] = LifeState::Rokicki(state[i], col0[i], col1[i], col0[i + 2], col1[i + 2]);
   }
-  return *this;
-}
-  LifeStateStripProxy &operator&=(LifeStateStrip strip){
-  for (unsigned i = 0; i < 4; i++) {
-    state->state[index.index + i] &= strip[i];
+
+  void Step(unsigned numIters) {
+    for (unsigned i = 0; i < numIters; i++)
+      Step();
   }
-  return *this;
+
+  LifeStateStrip Stepped(unsigned numIters = 1) const {
+    LifeStateStrip result = *this;
+    result.Step(numIters);
+    return result;
   }
-};
 
-inline LifeStateStrip::LifeStateStrip(const LifeStateStripProxy &proxy) {
-  for (unsigned i = 0; i < 4; i++) {
-    state[i] = proxy.state->state[proxy.index.index + i];
+  friend std::ostream &operator<<(std::ostream &os, const LifeStateStrip &self) {
+    LifeState blank;
+    self.Store(blank, {1});
+    return os << blank.RLE();
   }
-}
+};
 
-struct LifeStateStripConstProxy {
-  const LifeState *conststate;
-  StripIndex index;
+// As `NeighbourCount`, for a strip
+template <unsigned W = 4>
+struct StripNeighbourCount {
+  LifeStateStrip<W> bit3;
+  LifeStateStrip<W> bit2;
+  LifeStateStrip<W> bit1;
+  LifeStateStrip<W> bit0;
+
+  explicit StripNeighbourCount(const LifeStateStrip<W> &strip)
+      : bit3{InitializedTag::UNINITIALIZED}, bit2{InitializedTag::UNINITIALIZED},
+        bit1{InitializedTag::UNINITIALIZED}, bit0{InitializedTag::UNINITIALIZED} {
+    strip.CountNeighbourhood(bit3, bit2, bit1, bit0);
+  }
 
-  uint64_t operator[](const unsigned i) const { return conststate->state[index.index + i]; }
+  LifeStateStrip<W> WithExactly(unsigned n) const {
+    LifeStateStrip<W> result(InitializedTag::UNINITIALIZED);
+    for (unsigned i = 0; i < W; i++) {
+      result[i] = ((n & 1) ? bit0[i] : ~bit0[i]) &
+                  ((n & 2) ? bit1[i] : ~bit1[i]) &
+                  ((n & 4) ? bit2[i] : ~bit2[i]) &
+                  ((n & 8) ? bit3[i] : ~bit3[i]);
+    }
+    return result;
+  }
 };
 
-LifeStateStripProxy LifeState::operator[](const StripIndex column) {
-  return {this, column};
-}
-const LifeStateStripConstProxy LifeState::operator[](const StripIndex column) const {
-  return {this, column};
-}
-
+// The starts of strips of width W that together cover every column set
+// in `mask`, wrapping round rather than stopping short of the edge
+template <unsigned W = 4>
 struct StripIterator {
   struct IteratorState {
     using iterator_category = std::forward_iterator_tag;
@@ -122,12 +205,11 @@ struct StripIterator {
 
     IteratorState(uint64_t mask) : remaining(mask) {}
 
-    StripIndex operator*() const { return {static_cast<unsigned int>(std::min(std::countr_zero(remaining), N-4))}; }
+    StripIndex operator*() const { return {static_cast<unsigned>(std::countr_zero(remaining))}; }
 
     IteratorState &operator++() {
-      unsigned i = std::min(std::countr_zero(remaining), N - 4); // Don't wrap
-      uint64_t nyb = (1ULL << 4) - 1;
-      remaining &= ~(nyb << i);
+      constexpr uint64_t covered = W == 64 ? ~0ULL : (1ULL << W) - 1;
+      remaining &= ~std::rotl(covered, std::countr_zero(remaining));
       return *this;
     }
 
@@ -142,9 +224,3 @@ struct StripIterator {
   IteratorState begin() { return IteratorState(mask); }
   IteratorState end() { return IteratorState(0); }
 };
-
-std::ostream &operator<<(std::ostream &os, LifeStateStrip const &self) {
-  LifeState blank;
-  blank[StripIndex{1}] = self;
-  return os << blank.RLE();
-}
@@ -37,8 +37,18 @@ struct LifeTarget {
 
 inline bool LifeState::Contains(const LifeTarget &target, int dx,
                                 int dy) const {
-  return Contains(target.wanted, dx, dy) &&
-         AreDisjoint(target.unwanted, dx, dy);
+  return Contains(Translated(target, dx, dy));
+}
+
+inline bool LifeState::Contains(const Translated<const LifeTarget &> &target) const {
+  Translated wanted(target.base.wanted, target.dx, target.dy);
+  Translated unwanted(target.base.unwanted, target.dx, target.dy);
+  uint64_t differences = 0;
+  for (unsigned i = 0; i < N; i++) {
+    uint64_t live = wanted[i];
+    differences |= (state[i] ^ live) & (live | unwanted[i]);
+  }
+  return differences == 0;
 }
 
 inline bool LifeState::Contains(const LifeTarget &target) const {
@@ -52,4 +62,77 @@ inline bool LifeState::Contains(const LifeTarget &target) const {
 
 inline LifeState LifeState::Match(const LifeTarget &target) const {
   return MatchLiveAndDead(target.wanted, target.unwanted);
-}
\ No newline at end of file
+}
+
+// Follows where `target` matches as a reaction runs. After each `Update`
+// only the offsets whose wanted or unwanted cells overlap a cell that
+// changed since the last one are looked at again; everything else keeps
+// its previous answer, so a mostly-still board costs little.
+struct TargetMatcher {
+  // Past this many offsets to recheck, a full `Match` is faster
+  static constexpr unsigned maxRecheck = 256;
+
+  LifeTarget target;
+  LifeState previous;
+  LifeState matches;     // Offsets matching `previous`
+  LifeState appeared;    // Matching now but not before the last `Update`
+  LifeState disappeared; // The other way round
+
+  TargetMatcher(const LifeTarget &target, const LifeState &state)
+      : target{target}, footprintMirrored{(target.wanted | target.unwanted).Mirrored()} {
+    for (unsigned i = 0; i < N; i++)
+      if ((target.wanted[i] | target.unwanted[i]) != 0)
+        columns.push_back(i);
+    Reset(state);
+  }
+
+  // Everything matching `state` counts as having appeared
+  void Reset(const LifeState &state) {
+    previous = state;
+    matches = state.Match(target);
+    appeared = matches;
+    disappeared = LifeState();
+  }
+
+  void Update(const LifeState &state) {
+    LifeState changed = state ^ previous;
+    previous = state;
+    if (changed.IsEmpty()) {
+      appeared = LifeState();
+      disappeared = LifeState();
+      return;
+    }
+
+    LifeState stale = changed.Convolve(footprintMirrored);
+    LifeState rechecked;
+    if (stale.GetPop() > maxRecheck) {
+      rechecked = state.Match(target) & stale;
+    } else {
+      for (auto offset : stale.Cells())
+        if (MatchesAt(state, offset))
+          rechecked.Set(offset);
+    }
+
+    LifeState updated = (matches & ~stale) | rechecked;
+    appeared = updated & ~matches;
+    disappeared = matches & ~updated;
+    matches = updated;
+  }
+
+  bool Changed() const { return !appeared.IsEmpty() || !disappeared.IsEmpty(); }
+
+private:
+  LifeState footprintMirrored;
+  std::vector<unsigned> columns; // Those with any wanted or unwanted cells
+
+  // As `Contains(Translated(target, offset))`, over just `columns`
+  bool MatchesAt(const LifeState &state, std::pair<int, int> offset) const {
+    uint64_t differences = 0;
+    for (auto i : columns) {
+      uint64_t live = std::rotl(target.wanted[i], offset.second);
+      uint64_t dead = std::rotl(target.unwanted[i], offset.second);
+      differences |= (state[torus_wrap(i + offset.first)] ^ live) & (live | dead);
+    }
+    return differences == 0;
+  }
+};
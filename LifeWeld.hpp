@@ -5,8 +5,13 @@
 #include "LifeStable.hpp"
 #include "LifeHistory.hpp"
 #include "Parsing.hpp"
+#include "Threads.hpp"
 
+#include <atomic>
 #include <iostream>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 
 // LifeWeld is a cheap replacement for LifeStable, intended for
 // working with just the active part of a catalyst with as little of
@@ -15,6 +20,44 @@
 
 // Only non-active cells should have a non-zero frozen value.
 
+struct LifeWeld;
+
+// Weldability of (weld, other weld, offset) triples, shared between
+// threads and between calls, so a weldability matrix for a whole library
+// is only computed once.
+struct WeldCache {
+  struct Key {
+    uint64_t first;
+    uint64_t second;
+    std::pair<int, int> offset;
+
+    bool operator==(const Key &) const = default;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key &key) const {
+      return key.first ^ (key.second * 0x9e3779b97f4a7c15ULL) ^
+             (key.offset.first * N + key.offset.second);
+    }
+  };
+
+  std::mutex mutex;
+  std::unordered_map<Key, bool, KeyHash> unweldable;
+
+  std::optional<bool> Lookup(const Key &key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = unweldable.find(key);
+    if (it == unweldable.end())
+      return std::nullopt;
+    return it->second;
+  }
+
+  void Insert(const Key &key, bool bad) {
+    std::lock_guard<std::mutex> lock(mutex);
+    unweldable[key] = bad;
+  }
+};
+
 struct LifeWeld {
   LifeState state;
 
@@ -85,10 +128,14 @@ struct LifeWeld {
     return os << self.BellmanRLEWHeader();
   }
 
-  void Step();
+  void Step() { StepChanged(); }
+  // Returns false if the weld was already still
+  bool StepChanged();
   void Step(unsigned numIters) {
     for (unsigned i = 0; i < numIters; i++) {
-      Step();
+      // Nothing can happen after that
+      if (!StepChanged())
+        break;
     }
   }
   LifeWeld Stepped() const {
@@ -110,15 +157,28 @@ struct LifeWeld {
   LifeStable ToStable() const;
   LifeStable ToStable(const LifeState &active, unsigned duration, const LifeState &mask = ~LifeState()) const;
 
-  // Very expensive!
-  LifeState UnweldableMask(const LifeWeld &other, const LifeState &startingGood, const LifeState &startingBad) const;
-  LifeState UnweldableMask(const LifeWeld &other) const;
+  // Whether `this | other.Moved(offset)` has a stable completion:
+  // INCONSISTENT if not, TIMEOUT if the search ran out of time. Tries
+  // Propagate, then PropagateAndTest, before a full completion.
+  LifeStable::CompletionResult WeldResult(const LifeWeld &other, std::pair<int, int> offset, float timeout = 0.05) const;
+  // A timeout counts as weldable
+  bool Unweldable(const LifeWeld &other, std::pair<int, int> offset, float timeout = 0.05) const {
+    return WeldResult(other, offset, timeout) == LifeStable::CompletionResult::INCONSISTENT;
+  }
+
+  // Very expensive! The offsets are split over `threads` threads (0 for
+  // one per core). Offsets that time out count as weldable but are left
+  // out of `cache`, so a later call tries them again.
+  LifeState UnweldableMask(const LifeWeld &other, const LifeState &startingGood, const LifeState &startingBad, unsigned threads = 0, WeldCache *cache = nullptr, float timeout = 0.05) const;
+  LifeState UnweldableMask(const LifeWeld &other) const {
+    return UnweldableMask(other, LifeState(), LifeState());
+  }
 
   // For debugging
   LifeHistory ToHistory() const;
 };
 
-std::string LifeWeld::BellmanRLE(const LifeState &active) const {
+inline std::string LifeWeld::BellmanRLE(const LifeState &active) const {
   LifeState frozen = frozen2 | frozen1 | frozen0;
   LifeState marked = (state & frozen).ZOI() & ~(state & ~frozen).ZOI();
 
@@ -130,7 +190,7 @@ std::string LifeWeld::BellmanRLE(const LifeState &active) const {
   });
 }
 
-LifeWeld LifeWeld::FromRequired(const LifeState &state,
+inline LifeWeld LifeWeld::FromRequired(const LifeState &state,
                                 const LifeState &required) {
   LifeState active = state.ZOI() & ~required;
   LifeState stator = state & ~active.ZOI(); // Cells to be deleted
@@ -166,26 +226,43 @@ LifeWeld LifeWeld::FromRequired(const LifeState &state,
 //   return result;
 // }
 
-void LifeWeld::Step() {
-  // No doubt this could be fused to be more efficient
-  // mvrnote: bit3 irrelevant, should avoid computing it
-
-  LifeState bit3(InitializedTag::UNINITIALIZED), bit2(InitializedTag::UNINITIALIZED), bit1(InitializedTag::UNINITIALIZED),
-      bit0(InitializedTag::UNINITIALIZED);
-  state.CountNeighbourhood(bit3, bit2, bit1, bit0);
-
-  // Add the frozen counts to the actual counts:
-  LifeState sum2(InitializedTag::UNINITIALIZED), sum1(InitializedTag::UNINITIALIZED), sum0(InitializedTag::UNINITIALIZED);
-  LifeState carry2(InitializedTag::UNINITIALIZED), carry1(InitializedTag::UNINITIALIZED), carry0(InitializedTag::UNINITIALIZED);
-  LifeState::HalfAdd(sum0, carry0, bit0, frozen0);
-  LifeState::FullAdd(sum1, carry1, bit1, frozen1, carry0);
-  LifeState::FullAdd(sum2, carry2, bit2, frozen2, carry1);
+inline bool LifeWeld::StepChanged() {
+  LifeState col0(InitializedTag::UNINITIALIZED), col1(InitializedTag::UNINITIALIZED);
+  state.CountRows(col0, col1);
+
+  uint64_t changes = 0;
+
+  #pragma clang loop unroll(full)
+  for (unsigned i = 0; i < N; i++) {
+    unsigned idxU = (i + N - 1) % N;
+    unsigned idxB = (i + 1) % N;
+
+    // The 3x3 count mod 8: bit3 is irrelevant once the frozen counts are in
+    uint64_t uc0, uc1, uc2, uc_carry0;
+    LifeState::HalfAdd(uc0, uc_carry0, col0[idxU], col0[i]);
+    LifeState::FullAdd(uc1, uc2, col1[idxU], col1[i], uc_carry0);
+
+    uint64_t on0, on1, on_carry0, on_carry1;
+    LifeState::HalfAdd(on0, on_carry0, uc0, col0[idxB]);
+    LifeState::FullAdd(on1, on_carry1, uc1, col1[idxB], on_carry0);
+    uint64_t on2 = uc2 ^ on_carry1;
+
+    // Add the frozen counts to the actual counts:
+    uint64_t sum0, sum1, carry0, carry1;
+    LifeState::HalfAdd(sum0, carry0, on0, frozen0[i]);
+    LifeState::FullAdd(sum1, carry1, on1, frozen1[i], carry0);
+    uint64_t sum2 = on2 ^ frozen2[i] ^ carry1;
+
+    // Now apply the ordinary life rule:
+    uint64_t next = (sum0 ^ sum2) & (sum1 ^ sum2) & (state[i] | sum0);
+    changes |= next ^ state[i];
+    state[i] = next;
+  }
 
-  // Now apply the ordinary life rule:
-  state = (sum0 ^ sum2) & (sum1 ^ sum2) & (state | sum0);
+  return changes != 0;
 }
 
-LifeTarget LifeWeld::ToTarget() const {
+inline LifeTarget LifeWeld::ToTarget() const {
   LifeState nonFrozen = state & ~frozen2 & ~frozen1 & ~frozen0;
   return LifeTarget(state, nonFrozen.ZOI() & ~state);
 }
@@ -203,7 +280,7 @@ inline void LifeWeld::InteractionCounts(LifeState &__restrict__ out1,
   outMore &= nonFrozenZOI;
 }
 
-LifeState LifeWeld::InteractionOffsets(const LifeWeld &b) const {
+inline LifeState LifeWeld::InteractionOffsets(const LifeWeld &b) const {
   const LifeWeld &a = *this;
 
   // Mostly copy-pasted from LifeState, but we have to ignore
@@ -244,7 +321,25 @@ LifeState LifeWeld::InteractionOffsets(const LifeWeld &b) const {
       ((b_bit2 | b_bit3) & b_state & ~b_ignored).Convolve((a_bit3 | a_bit2 | a_bit1 | a_bit0) & ~a_state & ~a_ignored);
 }
 
-LifeState LifeWeld::UnweldableMask(const LifeWeld &other, const LifeState &startingGood, const LifeState &startingBad) const {
+inline LifeStable::CompletionResult LifeWeld::WeldResult(const LifeWeld &other, std::pair<int, int> offset, float timeout) const {
+  // Moved plane by plane as it is ORed in, this runs once per offset
+  LifeWeld placed = {state | Translated(other.state, offset),
+                     frozen2 | Translated(other.frozen2, offset),
+                     frozen1 | Translated(other.frozen1, offset),
+                     frozen0 | Translated(other.frozen0, offset)};
+  LifeStable stable = placed.ToStable();
+
+  // Cheap filters first, most offsets fail here
+  if (!stable.Propagate().consistent)
+    return LifeStable::CompletionResult::INCONSISTENT;
+  if (!stable.PropagateAndTest().consistent)
+    return LifeStable::CompletionResult::INCONSISTENT;
+
+  auto [placedResult, completedPlaced] = stable.CompleteStable(timeout, false);
+  return placedResult;
+}
+
+inline LifeState LifeWeld::UnweldableMask(const LifeWeld &other, const LifeState &startingGood, const LifeState &startingBad, unsigned threads, WeldCache *cache, float timeout) const {
   LifeState knownGood = startingGood;
   LifeState knownBad = InteractionOffsets(other) | startingBad;
 
@@ -252,31 +347,48 @@ LifeState LifeWeld::UnweldableMask(const LifeWeld &other, const LifeState &start
   // get catalysts slightly closer.
 
   LifeState toTest = ~knownGood & ~knownBad;
-
-  for (auto cell = toTest.FirstOn(); cell != std::make_pair(-1, -1);
-       toTest.Erase(cell), cell = toTest.FirstOn()) {
-    LifeWeld placed = *this | other.Moved(cell);
-
-    // auto propagateResult = placed.ToStable().Propagate();
-    // if (!propagateResult.consistent)
-    //   knownBad.Set(cell);
-    
-    auto [placedResult, completedPlaced] = placed.ToStable().CompleteStable(0.05, false);
-    switch (placedResult) {
-    case LifeStable::CompletionResult::COMPLETED:
-      break;
-    case LifeStable::CompletionResult::INCONSISTENT:
-      knownBad.Set(cell);
-      break;
-    case LifeStable::CompletionResult::TIMEOUT:
-      break;
+  std::vector<std::pair<int, int>> cells = toTest.OnCells();
+
+  uint64_t thisHash = GetHash();
+  uint64_t otherHash = other.GetHash();
+
+  std::atomic<unsigned> next = 0;
+  std::mutex resultMutex;
+
+  auto worker = [&]() {
+    LifeState bad;
+    for (unsigned i = next++; i < cells.size(); i = next++) {
+      auto cell = cells[i];
+      WeldCache::Key key = {thisHash, otherHash, cell};
+
+      std::optional<bool> cached;
+      if (cache != nullptr)
+        cached = cache->Lookup(key);
+
+      bool unweldable;
+      if (cached) {
+        unweldable = *cached;
+      } else {
+        auto result = WeldResult(other, cell, timeout);
+        unweldable = result == LifeStable::CompletionResult::INCONSISTENT;
+        if (cache != nullptr && result != LifeStable::CompletionResult::TIMEOUT)
+          cache->Insert(key, unweldable);
+      }
+
+      if (unweldable)
+        bad.Set(cell);
     }
-  }
+
+    std::lock_guard<std::mutex> lock(resultMutex);
+    knownBad |= bad;
+  };
+
+  RunWorkers(threads, worker, cells.size());
 
   return knownBad;
 }
 
-LifeStable LifeWeld::ToStable() const {
+inline LifeStable LifeWeld::ToStable() const {
   LifeStable stable;
   stable.unknown = ~LifeState();
 
@@ -304,13 +416,14 @@ LifeStable LifeWeld::ToStable() const {
   stable.SetOn(state);
   stable.SetOff(~state & nonFrozenZOI);
 
-  stable.RestrictOptions(frozen &  state & sumCounts.WithExactly(3), StableOptions::LIVE2); // Remember the sum includes the center square
-  stable.RestrictOptions(frozen &  state & sumCounts.WithExactly(4), StableOptions::LIVE3);
-  stable.RestrictOptions(frozen & ~state & sumCounts.WithExactly(1), StableOptions::DEAD1);
-  stable.RestrictOptions(frozen & ~state & sumCounts.WithExactly(2), StableOptions::DEAD2);
-  stable.RestrictOptions(frozen & ~state & sumCounts.WithExactly(4), StableOptions::DEAD4);
-  stable.RestrictOptions(frozen & ~state & sumCounts.WithExactly(5), StableOptions::DEAD5);
-  stable.RestrictOptions(frozen & ~state & sumCounts.WithExactly(6), StableOptions::DEAD6);
+  NeighbourClasses sum = sumCounts.Classes<0b1111110>();
+  stable.RestrictOptions(frozen &  state & sum[3], StableOptions::LIVE2); // Remember the sum includes the center square
+  stable.RestrictOptions(frozen &  state & sum[4], StableOptions::LIVE3);
+  stable.RestrictOptions(frozen & ~state & sum[1], StableOptions::DEAD1);
+  stable.RestrictOptions(frozen & ~state & sum[2], StableOptions::DEAD2);
+  stable.RestrictOptions(frozen & ~state & sum[4], StableOptions::DEAD4);
+  stable.RestrictOptions(frozen & ~state & sum[5], StableOptions::DEAD5);
+  stable.RestrictOptions(frozen & ~state & sum[6], StableOptions::DEAD6);
 
   // `FromRequired` is not accurate enough for this to work: in an eater only two cells are frozen
   // stable.RestrictOptions(nonFrozenZOI &  state & sumCounts.WithExactly(3), StableOptions::LIVE2); // Remember the sum includes the center square
@@ -324,81 +437,87 @@ LifeStable LifeWeld::ToStable() const {
   return stable;
 }
 
-LifeStable LifeWeld::ToStable(const LifeState &active, unsigned duration, const LifeState &mask) const {
+inline LifeStable LifeWeld::ToStable(const LifeState &active, unsigned duration, const LifeState &mask) const {
   LifeStable stable = ToStable();
 
-  LifeState everActive;
-
-  // Replay the reaction to determine region we can use
-  
-  LifeWeld current = *this;
-  current.state |= active;
-  
-  for (unsigned i = 0; i < duration; i++) {
-    everActive |= this->state ^ current.state;
-    current.Step();
-  }
-
-  stable.SetOff(mask & ~state & everActive);
-  
-  // Replay the reaction to make sure correct births happen
+  // Replay the reaction once, both to determine the region we can use
+  // and to make sure the correct births happen
 
   // mvrnote: it's a bit annoying we can't just use the history
   // information from the search, but there's not enough information
   // in there
 
-  NeighbourCount stateCounts(state);
+  const NeighbourCount stateCounts(state);
+  const NeighbourClasses stateClasses = stateCounts.Classes<0b111>();
+  const LifeState &state0 = stateClasses[0];
+  const LifeState &state1 = stateClasses[1];
+  const LifeState &state2 = stateClasses[2];
+
+  // Cells restricted to exactly that option by a birth, and cells where
+  // that option is ruled out by a cell staying dead
+  LifeState onlyDead0, onlyDead1, onlyDead2;
+  LifeState notDead1, notDead2, notDead4, notDead5, notDead6;
 
-  current = *this;
+  LifeState everActive;
+
+  LifeWeld current = *this;
   current.state |= active;
 
   for (unsigned i = 0; i < duration; i++) {
+    everActive |= this->state ^ current.state;
+
     LifeWeld next = current;
     next.Step();
 
-    LifeState stayDead = ~state & ~current.state & ~next.state;
-    LifeState getsBorn = ~state & ~current.state &  next.state;
-
-    NeighbourCount currentCounts(current.state);
-
-    // mvrnote: TODO; this sucks, should do it by NeighbourCount subtraction (clamping at 0)
-
-    // LifeStable copy = stable;
-    // auto result = copy.CompleteStable(1, false);
-    // if(result.first == LifeStable::CompletionResult::INCONSISTENT) {
-    // LifeState bad = ~state & stayDead & currentCounts.WithExactly(1) & stateCounts.WithExactly(0);
-    //   std::cout << "Bad" << std::endl;
-    //   std::cout << current << std::endl;
-    //   std::cout << LifeHistory(state, LifeState(), bad) << std::endl;
-    //   return stable;
-    // }
-
-    stable.RestrictOptions(mask & getsBorn & currentCounts.WithExactly(3) & stateCounts.WithExactly(0), StableOptions::DEAD0);
-    stable.RestrictOptions(mask & getsBorn & currentCounts.WithExactly(3) & stateCounts.WithExactly(1), StableOptions::DEAD1);
-    stable.RestrictOptions(mask & getsBorn & currentCounts.WithExactly(3) & stateCounts.WithExactly(2), StableOptions::DEAD2);
-
-    stable.RestrictOptions(mask & stayDead & currentCounts.WithExactly(1) & stateCounts.WithExactly(0), ~StableOptions::DEAD2);
-    stable.RestrictOptions(mask & stayDead & currentCounts.WithExactly(2) & stateCounts.WithExactly(0), ~StableOptions::DEAD1);
-    stable.RestrictOptions(mask & stayDead & currentCounts.WithExactly(2) & stateCounts.WithExactly(1), ~StableOptions::DEAD2);
+    LifeState stayDead = mask & ~state & ~current.state & ~next.state;
+    LifeState getsBorn = mask & ~state & ~current.state &  next.state;
+
+    const NeighbourCount currentCounts(current.state);
+    const NeighbourClasses currentClasses = currentCounts.Classes<0b1111>();
+    const LifeState &current1 = currentClasses[1];
+    const LifeState &current2 = currentClasses[2];
+    const LifeState &current3 = currentClasses[3];
+
+    LifeState born3 = getsBorn & current3;
+    onlyDead0 |= born3 & state0;
+    onlyDead1 |= born3 & state1;
+    onlyDead2 |= born3 & state2;
+
+    // A cell that stays dead with `c` live neighbours now and `s` in the
+    // stator would have been born if the completion gave it 3 - c more,
+    // so its final count can't be s + 3 - c. Where the reaction gained
+    // neighbours there are only three such pairs; where it lost them
+    // that is `s` plus however many were lost.
+    notDead1 |= stayDead & (current2 & state0);
+    notDead2 |= stayDead & ((current1 & state0) | (current2 & state1));
+
+    // Nothing is lost while the whole stator is still there
+    if (!(state & ~current.state).IsEmpty()) {
+      const NeighbourClasses lost = stateCounts.SubtractClamped(currentCounts).Classes<0b1110>();
+      const LifeState deadUpTo3 = stayDead & (currentClasses[0] | current1 | current2 | current3);
+      notDead4 |= deadUpTo3 & lost[1];
+      notDead5 |= deadUpTo3 & lost[2];
+      notDead6 |= deadUpTo3 & lost[3];
+    }
 
-    stable.RestrictOptions(mask & stayDead & currentCounts.WithExactly(1) & stateCounts.WithExactly(2), ~StableOptions::DEAD4);
-    stable.RestrictOptions(mask & stayDead & currentCounts.WithExactly(0) & stateCounts.WithExactly(2), ~StableOptions::DEAD5);
+    current = next;
+  }
 
-    stable.RestrictOptions(mask & stayDead & currentCounts.WithExactly(3) & stateCounts.WithExactly(4), ~StableOptions::DEAD4);
-    stable.RestrictOptions(mask & stayDead & currentCounts.WithExactly(2) & stateCounts.WithExactly(4), ~StableOptions::DEAD5);
-    stable.RestrictOptions(mask & stayDead & currentCounts.WithExactly(1) & stateCounts.WithExactly(4), ~StableOptions::DEAD6);
+  stable.SetOff(mask & ~state & everActive);
 
-    stable.RestrictOptions(mask & stayDead & currentCounts.WithExactly(3) & stateCounts.WithExactly(5), ~StableOptions::DEAD5);
-    stable.RestrictOptions(mask & stayDead & currentCounts.WithExactly(2) & stateCounts.WithExactly(5), ~StableOptions::DEAD6);
+  stable.RestrictOptions(onlyDead0, StableOptions::DEAD0);
+  stable.RestrictOptions(onlyDead1, StableOptions::DEAD1);
+  stable.RestrictOptions(onlyDead2, StableOptions::DEAD2);
 
-    stable.RestrictOptions(mask & stayDead & currentCounts.WithExactly(3) & stateCounts.WithExactly(6), ~StableOptions::DEAD6);
+  stable.RestrictOptions(notDead1, ~StableOptions::DEAD1);
+  stable.RestrictOptions(notDead2, ~StableOptions::DEAD2);
+  stable.RestrictOptions(notDead4, ~StableOptions::DEAD4);
+  stable.RestrictOptions(notDead5, ~StableOptions::DEAD5);
+  stable.RestrictOptions(notDead6, ~StableOptions::DEAD6);
 
-    current = next;
-  }
-   
   return stable;
 }
 
-LifeHistory LifeWeld::ToHistory() const {
+inline LifeHistory LifeWeld::ToHistory() const {
   return LifeHistory(state, LifeState(), AllFrozen());
 }
@@ -4,6 +4,23 @@
 
 #include "LifeAPI.hpp"
 
+// The cells with each possible count from 0 to 9, see
+// `NeighbourCount::Classes`
+struct NeighbourClasses {
+  static constexpr unsigned count = 10;
+  LifeState exactly[count];
+
+  NeighbourClasses()
+  : exactly{LifeState(InitializedTag::UNINITIALIZED), LifeState(InitializedTag::UNINITIALIZED),
+            LifeState(InitializedTag::UNINITIALIZED), LifeState(InitializedTag::UNINITIALIZED),
+            LifeState(InitializedTag::UNINITIALIZED), LifeState(InitializedTag::UNINITIALIZED),
+            LifeState(InitializedTag::UNINITIALIZED), LifeState(InitializedTag::UNINITIALIZED),
+            LifeState(InitializedTag::UNINITIALIZED), LifeState(InitializedTag::UNINITIALIZED)} {}
+
+  LifeState &operator[](unsigned n) { return exactly[n]; }
+  const LifeState &operator[](unsigned n) const { return exactly[n]; }
+};
+
 struct NeighbourCount {
   LifeState bit3;
   LifeState bit2;
@@ -22,52 +39,92 @@ struct NeighbourCount {
     return result;
   }
 
+  // For each cell, the count of it and the cells above and below, as two
+  // bits
+  static void CountRow(uint64_t a, uint64_t &on0, uint64_t &on1) {
+    uint64_t l = std::rotl(a, 1);
+    uint64_t r = std::rotr(a, 1);
+
+    on0 = l ^ r ^ a;
+    on1 = ((l ^ r) & a) | (l & r);
+  }
+
   static void CountRows(const LifeState &state,
                         uint64_t (&col0)[N + 2],
                         uint64_t (&col1)[N + 2]) {
-    for (unsigned i = 0; i < N; i++) {
-      uint64_t a = state.state[i];
-      uint64_t l = std::rotl(a, 1);
-      uint64_t r = std::rotr(a, 1);
-
-      col0[i+1] = l ^ r ^ a;
-      col1[i+1] = ((l ^ r) & a) | (l & r);
-    }
+    for (unsigned i = 0; i < N; i++)
+      CountRow(state.state[i], col0[i+1], col1[i+1]);
     col0[0] = col0[N]; col0[N+1] = col0[1];
     col1[0] = col1[N]; col1[N+1] = col1[1];
   }
 
+  // Adds the row counts of columns i - 1, i and i + 1 into column i
+  void AddRows(unsigned i,
+               uint64_t u_on0, uint64_t c_on0, uint64_t l_on0,
+               uint64_t u_on1, uint64_t c_on1, uint64_t l_on1) {
+    uint64_t on3, on2, on1, on0;
+
+    uint64_t uc0, uc1, uc2, uc_carry0;
+    LifeState::HalfAdd(uc0, uc_carry0, u_on0, c_on0);
+    LifeState::FullAdd(uc1, uc2, u_on1, c_on1, uc_carry0);
+
+    uint64_t on_carry1, on_carry0;
+    LifeState::HalfAdd(on0, on_carry0, uc0, l_on0);
+    LifeState::FullAdd(on1, on_carry1, uc1, l_on1, on_carry0);
+    LifeState::HalfAdd(on2, on3, uc2, on_carry1);
+
+    bit3.state[i] = on3;
+    bit2.state[i] = on2;
+    bit1.state[i] = on1;
+    bit0.state[i] = on0;
+  }
+
   NeighbourCount(const LifeState &state)
   : bit3{InitializedTag::UNINITIALIZED}, bit2{InitializedTag::UNINITIALIZED}, bit1{InitializedTag::UNINITIALIZED}, bit0{InitializedTag::UNINITIALIZED} {
     uint64_t col0[N + 2];
     uint64_t col1[N + 2];
     CountRows(state, col0, col1);
 
-    for (unsigned i = 0; i < N; i++) {
-      uint64_t u_on0 = col0[i];
-      uint64_t c_on0 = col0[i+1];
-      uint64_t l_on0 = col0[i+2];
-      uint64_t u_on1 = col1[i];
-      uint64_t c_on1 = col1[i+1];
-      uint64_t l_on1 = col1[i+2];
-
-      uint64_t on3, on2, on1, on0;
-
-      uint64_t uc0, uc1, uc2, uc_carry0;
-      LifeState::HalfAdd(uc0, uc_carry0, u_on0, c_on0);
-      LifeState::FullAdd(uc1, uc2, u_on1, c_on1, uc_carry0);
-
-      uint64_t on_carry1, on_carry0;
-      LifeState::HalfAdd(on0, on_carry0, uc0, l_on0);
-      LifeState::FullAdd(on1, on_carry1, uc1, l_on1, on_carry0);
-      LifeState::HalfAdd(on2, on3, uc2, on_carry1);
-
-      bit3.state[i] = on3;
-      bit2.state[i] = on2;
-      bit1.state[i] = on1;
-      bit0.state[i] = on0;
+    for (unsigned i = 0; i < N; i++)
+      AddRows(i, col0[i], col0[i+1], col0[i+2], col1[i], col1[i+1], col1[i+2]);
+  }
+
+  // Brings the counts up to date with `state`, given the cells that have
+  // changed since they were taken. Only the columns next to a change are
+  // recounted, unless there are so many that starting again is quicker.
+  void Update(const LifeState &state, const LifeState &changed) {
+    Update(state, DirtyColumns(changed));
+  }
+
+  // The columns whose counts depend on `changed`, for `Update`
+  static uint64_t DirtyColumns(const LifeState &changed) {
+    uint64_t dirty = changed.PopulatedColumns();
+    return dirty | std::rotl(dirty, 1) | std::rotr(dirty, 1);
+  }
+
+  void Update(const LifeState &state, uint64_t dirty) {
+    if (dirty == 0)
+      return;
+    if (std::popcount(dirty) > maxUpdateColumns) {
+      *this = NeighbourCount(state);
+      return;
+    }
+
+    while (dirty != 0) {
+      unsigned i = std::countr_zero(dirty);
+      dirty &= dirty - 1;
+
+      uint64_t u_on0, u_on1, c_on0, c_on1, l_on0, l_on1;
+      CountRow(state[torus_wrap(i - 1)], u_on0, u_on1);
+      CountRow(state[i], c_on0, c_on1);
+      CountRow(state[torus_wrap(i + 1)], l_on0, l_on1);
+      AddRows(i, u_on0, c_on0, l_on0, u_on1, c_on1, l_on1);
     }
   }
+
+  // Past this, the vectorised full count wins
+  static constexpr int maxUpdateColumns = 8;
+
   inline NeighbourCount Add(const NeighbourCount &other, const LifeState &incarry) const {
     NeighbourCount result;
     LifeState carry = incarry;
@@ -90,7 +147,24 @@ struct NeighbourCount {
     return Add(~other, ~LifeState());
   }
 
-  inline LifeState WithExactly(unsigned n) {
+  // `this - other`, or 0 where that would go below 0
+  inline NeighbourCount SubtractClamped(const NeighbourCount &other) const {
+    // As `Subtract`, keeping the carry out of `this + ~other + 1`, which
+    // is set exactly where nothing was borrowed
+    NeighbourCount result;
+    LifeState carry = ~LifeState();
+    LifeState::FullAdd(result.bit0, carry, bit0, ~other.bit0, carry);
+    LifeState::FullAdd(result.bit1, carry, bit1, ~other.bit1, carry);
+    LifeState::FullAdd(result.bit2, carry, bit2, ~other.bit2, carry);
+    LifeState::FullAdd(result.bit3, carry, bit3, ~other.bit3, carry);
+    result.bit3 &= carry;
+    result.bit2 &= carry;
+    result.bit1 &= carry;
+    result.bit0 &= carry;
+    return result;
+  }
+
+  inline LifeState WithExactly(unsigned n) const {
     LifeState result = ~LifeState();
 
     if (n & (1<<0)) result &= bit0; else result &= ~bit0;
@@ -101,6 +175,28 @@ struct NeighbourCount {
     return result;
   }
 
+  // `WithExactly(n)` for every n at once, in a single pass. Only the
+  // counts with their bit set in `Which` are filled in, the others are
+  // left uninitialised.
+  template <unsigned Which = 0x3FF>
+  inline NeighbourClasses Classes() const {
+    static_assert(Which < (1 << NeighbourClasses::count));
+
+    NeighbourClasses result;
+    for (unsigned i = 0; i < N; i++) {
+      // Each count is one of the low pairs of bits and one of the high
+      // pairs, so those are only worked out once
+      const uint64_t low[4] = {~bit1[i] & ~bit0[i], ~bit1[i] & bit0[i],
+                               bit1[i] & ~bit0[i], bit1[i] & bit0[i]};
+      const uint64_t high[3] = {~bit3[i] & ~bit2[i], ~bit3[i] & bit2[i],
+                                bit3[i] & ~bit2[i]};
+      for (unsigned n = 0; n < NeighbourClasses::count; n++)
+        if (Which & (1 << n))
+          result[n][i] = high[n >> 2] & low[n & 3];
+    }
+    return result;
+  }
+
   // inline NeighbourCount Add(uint64_t mask, const NeighbourCount &other, const LifeState &incarry) const {
   //   NeighbourCount result;
   //   LifeState carry = incarry;
@@ -116,3 +212,4 @@ struct NeighbourCount {
   //   return Add(mask, ~other, ~LifeState());
   // }
 };
+
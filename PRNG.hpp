@@ -0,0 +1,124 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <random>
+
+// Seedable random generators, one per thread by default, so that
+// parallel searches don't race on a shared engine and a failing job can
+// be rerun from its seed.
+
+namespace PRNG {
+
+constexpr uint64_t SplitMix64(uint64_t &state) {
+  uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+// xoshiro256** (Blackman and Vigna). Usable anywhere a standard
+// UniformRandomBitGenerator is.
+class Xoshiro256 {
+public:
+  using result_type = uint64_t;
+
+  constexpr explicit Xoshiro256(uint64_t seed = 0) { Seed(seed); }
+
+  constexpr void Seed(uint64_t seed) {
+    for (auto &word : s)
+      word = SplitMix64(seed);
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return ~0ULL; }
+
+  constexpr result_type operator()() {
+    uint64_t result = std::rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = std::rotl(s[3], 45);
+    return result;
+  }
+
+private:
+  uint64_t s[4];
+};
+
+// Four xoshiro256** streams stepped side by side. The lanes are
+// independent, so the loops in `Next` vectorise, which makes filling a
+// whole LifeState much cheaper than 64 separate calls.
+class Xoshiro256x4 {
+public:
+  using result_type = uint64_t;
+  static constexpr unsigned lanes = 4;
+
+  constexpr explicit Xoshiro256x4(uint64_t seed = 0) { Seed(seed); }
+
+  constexpr void Seed(uint64_t seed) {
+    for (auto &word : s)
+      for (auto &lane : word)
+        lane = SplitMix64(seed);
+    buffered = lanes;
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return ~0ULL; }
+
+  constexpr void Next(uint64_t *out) {
+    uint64_t t[lanes];
+    for (unsigned i = 0; i < lanes; i++) {
+      out[i] = std::rotl(s[1][i] * 5, 7) * 9;
+      t[i] = s[1][i] << 17;
+    }
+    for (unsigned i = 0; i < lanes; i++) {
+      s[2][i] ^= s[0][i];
+      s[3][i] ^= s[1][i];
+      s[1][i] ^= s[2][i];
+      s[0][i] ^= s[3][i];
+      s[2][i] ^= t[i];
+      s[3][i] = std::rotl(s[3][i], 45);
+    }
+  }
+
+  // The same words as `count` calls to `operator()`, but whole blocks
+  // go straight to `out`
+  constexpr void Fill(uint64_t *out, unsigned count) {
+    unsigned i = 0;
+    for (; i < count && buffered < lanes; i++)
+      out[i] = buffer[buffered++];
+    for (; i + lanes <= count; i += lanes)
+      Next(out + i);
+    for (; i < count; i++)
+      out[i] = (*this)();
+  }
+
+  constexpr result_type operator()() {
+    if (buffered == lanes) {
+      Next(buffer);
+      buffered = 0;
+    }
+    return buffer[buffered++];
+  }
+
+private:
+  uint64_t s[4][lanes];
+  uint64_t buffer[lanes] = {};
+  unsigned buffered = lanes;
+};
+
+// The generator used by `LifeState::RandomState()` on this thread. It
+// starts from a random seed; call `Seed` to make a run reproducible.
+inline Xoshiro256x4 &ThreadGenerator() {
+  thread_local Xoshiro256x4 generator(
+      (uint64_t)std::random_device{}() << 32 | std::random_device{}());
+  return generator;
+}
+
+inline void Seed(uint64_t seed) { ThreadGenerator().Seed(seed); }
+
+} // namespace PRNG
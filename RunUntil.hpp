@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <utility>
+
+#include "LifeAPI.hpp"
+#include "LifeTarget.hpp"
+
+// Steps a pattern until one of several conditions holds. The conditions
+// are checked column by column inside the step itself, so however many
+// there are each generation is still one pass over the board:
+//
+//   auto result = RunUntil(state, 100, PopulationAbove{200},
+//                          ContainsTarget{catalyst}, TouchesCells{forbidden});
+//   if (result.predicate == 1) ...
+//
+// A predicate is any struct with
+//   void Column(unsigned i, uint64_t before, uint64_t after, uint64_t &acc);
+//   bool Fired(uint64_t acc);
+// where `before` and `after` are column i before and after the step, and
+// `acc` starts at 0 each generation. It is kept outside the predicate so
+// it can stay in a register for the whole pass.
+
+struct RunUntilResult {
+  unsigned generation; // When it stopped, the first step being 1
+  int predicate;       // Index of the first that fired, -1 if maxGen ran out
+
+  bool Fired() const { return predicate >= 0; }
+};
+
+struct PopulationAbove {
+  unsigned max;
+
+  void Column(unsigned, uint64_t, uint64_t after, uint64_t &pop) const { pop += std::popcount(after); }
+  bool Fired(uint64_t pop) const { return pop > max; }
+};
+
+struct PopulationBelow {
+  unsigned min;
+
+  void Column(unsigned, uint64_t, uint64_t after, uint64_t &pop) const { pop += std::popcount(after); }
+  bool Fired(uint64_t pop) const { return pop < min; }
+};
+
+// The target is present, say a catalyst that has recovered
+struct ContainsTarget {
+  const LifeTarget &target;
+
+  void Column(unsigned i, uint64_t, uint64_t after, uint64_t &differences) const {
+    differences |= (after ^ target.wanted[i]) & (target.wanted[i] | target.unwanted[i]);
+  }
+  bool Fired(uint64_t differences) const { return differences == 0; }
+};
+
+// Any live cell in `cells`, say a forbidden zone
+struct TouchesCells {
+  const LifeState &cells;
+
+  void Column(unsigned i, uint64_t, uint64_t after, uint64_t &hits) const { hits |= after & cells[i]; }
+  bool Fired(uint64_t hits) const { return hits != 0; }
+};
+
+// Any live cell outside `region`, say activity getting near the edge of
+// the torus
+struct Escapes {
+  const LifeState &region;
+
+  void Column(unsigned i, uint64_t, uint64_t after, uint64_t &outside) const { outside |= after & ~region[i]; }
+  bool Fired(uint64_t outside) const { return outside != 0; }
+};
+
+// The same as `Period` generations before
+template <unsigned Period = 1>
+struct Stabilised {
+  static_assert(Period >= 1);
+
+  // Only needed to look back further than one generation
+  std::array<LifeState, Period - 1> past{};
+  unsigned generation = 0;
+
+  void Column(unsigned i, uint64_t before, uint64_t after, uint64_t &differences) {
+    if constexpr (Period == 1) {
+      differences |= before ^ after;
+    } else {
+      // Holds the generation `Period - 1` before `before`
+      LifeState &slot = past[generation % (Period - 1)];
+      differences |= slot[i] ^ after;
+      slot[i] = before;
+    }
+  }
+
+  bool Fired(uint64_t differences) {
+    generation++;
+    return generation >= Period && differences == 0;
+  }
+};
+
+template <typename... Predicates, std::size_t... Is>
+inline RunUntilResult RunUntilImpl(LifeState &state, unsigned maxGen,
+                                   std::index_sequence<Is...>, Predicates &...predicates) {
+  for (unsigned gen = 1; gen <= maxGen; gen++) {
+    // As `CountRows`, with a column of padding either side so the loop
+    // below needs no wrapping and vectorises
+    uint64_t col0[N + 2];
+    uint64_t col1[N + 2];
+    for (unsigned i = 0; i < N; i++) {
+      uint64_t a = state[i];
+      uint64_t l = std::rotl(a, 1);
+      uint64_t r = std::rotr(a, 1);
+
+      col0[i + 1] = l ^ r ^ a;
+      col1[i + 1] = ((l ^ r) & a) | (l & r);
+    }
+    col0[0] = col0[N];
+    col1[0] = col1[N];
+    col0[N + 1] = col0[1];
+    col1[N + 1] = col1[1];
+
+    LifeState next(InitializedTag::UNINITIALIZED);
+    uint64_t accs[sizeof...(Predicates)] = {};
+    for (unsigned i = 0; i < N; i++) {
+      uint64_t after = LifeState::Rokicki(state[i], col0[i], col1[i], col0[i + 2], col1[i + 2]);
+      (predicates.Column(i, state[i], after, accs[Is]), ...);
+      next[i] = after;
+    }
+    state = next;
+
+    // Every predicate is asked, as `Stabilised` counts the generations
+    bool fired[] = {predicates.Fired(accs[Is])...};
+    for (unsigned i = 0; i < sizeof...(Predicates); i++)
+      if (fired[i])
+        return {gen, (int)i};
+  }
+  return {maxGen, -1};
+}
+
+template <typename... Predicates>
+inline RunUntilResult RunUntil(LifeState &state, unsigned maxGen, Predicates &&...predicates) {
+  static_assert(sizeof...(Predicates) > 0, "Use Step(maxGen) instead");
+  return RunUntilImpl(state, maxGen, std::index_sequence_for<Predicates...>(), predicates...);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <initializer_list>
+
+// A vector that keeps up to `Capacity` items inline, for short results
+// like symmetry groups that would otherwise cost a heap allocation on
+// every call. Pushing past the capacity is not checked.
+template <typename T, unsigned Capacity>
+class StaticVector {
+public:
+  constexpr StaticVector() = default;
+  constexpr StaticVector(std::initializer_list<T> init) {
+    for (auto &item : init)
+      push_back(item);
+  }
+
+  constexpr void push_back(const T &item) { items[count++] = item; }
+  constexpr void clear() { count = 0; }
+
+  constexpr unsigned size() const { return count; }
+  constexpr bool empty() const { return count == 0; }
+  static constexpr unsigned capacity() { return Capacity; }
+
+  constexpr T *data() { return items; }
+  constexpr const T *data() const { return items; }
+  constexpr T *begin() { return items; }
+  constexpr T *end() { return items + count; }
+  constexpr const T *begin() const { return items; }
+  constexpr const T *end() const { return items + count; }
+
+  constexpr T &operator[](unsigned i) { return items[i]; }
+  constexpr const T &operator[](unsigned i) const { return items[i]; }
+  constexpr T &back() { return items[count - 1]; }
+  constexpr const T &back() const { return items[count - 1]; }
+
+  constexpr bool operator==(const StaticVector &other) const {
+    return std::equal(begin(), end(), other.begin(), other.end());
+  }
+
+private:
+  T items[Capacity];
+  unsigned count = 0;
+};
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <algorithm>
+#include <limits>
 
 #include "LifeAPI.hpp"
+#include "StaticVector.hpp"
 
 enum struct SymmetryTransform : uint32_t {
   Identity,
@@ -172,7 +174,10 @@ inline void LifeState::Transform(SymmetryTransform transf) {
   }
 }
 
-inline std::vector<SymmetryTransform> SymmetryGroupFromEnum(const StaticSymmetry sym) {
+// At most 8 transforms, so these are kept off the heap
+using SymmetryTransforms = StaticVector<SymmetryTransform, 8>;
+
+inline SymmetryTransforms SymmetryGroupFromEnum(const StaticSymmetry sym) {
   using enum SymmetryTransform;
   switch (sym) {
   case StaticSymmetry::C1:
@@ -230,7 +235,7 @@ inline std::vector<SymmetryTransform> SymmetryGroupFromEnum(const StaticSymmetry
   }
 }
 
-inline std::vector<SymmetryTransform> SymmetryChainFromEnum(const StaticSymmetry sym) {
+inline SymmetryTransforms SymmetryChainFromEnum(const StaticSymmetry sym) {
   using enum SymmetryTransform;
   switch (sym) {
   case StaticSymmetry::C1:
@@ -334,6 +339,9 @@ constexpr LifeState FundamentalDomain(const StaticSymmetry sym) {
         "30o$29o$28o$27o$26o$25o$24o$23o$22o$21o$20o$19o$18o$17o$16o$15o$14o$"
         "13o$12o$11o$10o$9o$8o$7o$6o$5o$4o$3o!");
   case StaticSymmetry::D8:
+    return LifeState::ConstantParse(
+        "2o$3o$4o$5o$6o$7o$8o$9o$10o$11o$12o$13o$14o$15o$16o$17o$18o$19o$20o$"
+        "21o$22o$23o$24o$25o$26o$27o$28o$29o$30o$31o$32o$33o$33o!");
   case StaticSymmetry::D8even:
     return LifeState::ConstantParse(
         "o$2o$3o$4o$5o$6o$7o$8o$9o$10o$11o$12o$13o$14o$15o$16o$17o$18o$19o$20o$"
@@ -512,7 +520,7 @@ inline std::string SymmetryToString(StaticSymmetry sym) {
   }
 }
 
-inline std::vector<SymmetryTransform> CharToTransforms(char ch) {
+inline SymmetryTransforms CharToTransforms(char ch) {
   switch (ch) {
   case '.':
     return SymmetryGroupFromEnum(StaticSymmetry::C1);
@@ -562,6 +570,26 @@ inline std::pair<int, int> PerpComponent(SymmetryTransform transf,
   }
 }
 
+// The symmetries `Symmetricize` knows how to apply. The even variants
+// are not among them.
+inline bool CanSymmetricize(StaticSymmetry sym) {
+  switch (sym) {
+  case StaticSymmetry::C1:
+  case StaticSymmetry::C2:
+  case StaticSymmetry::C4:
+  case StaticSymmetry::D2AcrossX:
+  case StaticSymmetry::D2AcrossY:
+  case StaticSymmetry::D2diagodd:
+  case StaticSymmetry::D2negdiagodd:
+  case StaticSymmetry::D4:
+  case StaticSymmetry::D4diag:
+  case StaticSymmetry::D8:
+    return true;
+  default:
+    return false;
+  }
+}
+
 inline LifeState Symmetricize(const LifeState &state, StaticSymmetry sym,
                                  std::pair<int, int> offset) {
   switch (sym) {
@@ -647,42 +675,25 @@ inline LifeState Symmetricize(const LifeState &state, StaticSymmetry sym,
 
     return acrossx;
   }
+  case StaticSymmetry::D8:
+    return Symmetricize(Symmetricize(state, StaticSymmetry::D4, offset),
+                        StaticSymmetry::D4diag, offset);
 
   default:
     __builtin_unreachable();
   }
 }
 
-// On intel there is a single instruction for this
-// Taken from Hacker's Delight
-inline uint64_t compress_right(uint64_t x, uint64_t m) {
-   uint64_t mk, mp, mv, t;
-   int i;
-
-   x = x & m;           // Clear irrelevant bits.
-   mk = ~m << 1;        // We will count 0's to right.
-
-   for (i = 0; i < 6; i++) {
-      mp = mk ^ (mk << 1);             // Parallel prefix.
-      mp = mp ^ (mp << 2);
-      mp = mp ^ (mp << 4);
-      mp = mp ^ (mp << 8);
-      mp = mp ^ (mp << 16);
-      mp = mp ^ (mp << 32);
-      mv = mp & m;                     // Bits to move.
-      m = (m ^ mv) | (mv >> (1 << i));   // Compress m.
-      t = x & mv;
-      x = (x ^ t) | (t >> (1 << i));     // Compress x.
-      mk = mk & ~mp;
-   }
-   return x;
-}
-
 inline LifeState LifeState::Halve() const {
-  LifeState result;
+  uint64_t evens[N/2];
+  for (int i = 0; i < N/2; i++)
+    evens[i] = state[2*i];
+  uint64_t halved[N/2];
+  compress_right(evens, halved, N/2, 0x5555555555555555ULL);
+
+  LifeState result(InitializedTag::UNINITIALIZED);
   for(int i = 0; i < N/2; i++){
-    uint64_t halvedColumn = compress_right(state[2*i], 0x5555555555555555ULL);
-    halvedColumn |= halvedColumn << N/2;
+    uint64_t halvedColumn = halved[i] | halved[i] << N/2;
     result.state[i] = halvedColumn;
     result.state[i + N/2] = halvedColumn;
   }
@@ -699,12 +710,40 @@ inline LifeState LifeState::HalveX() const {
 }
 
 inline LifeState LifeState::HalveY() const {
-  LifeState result;
-  for(int i = 0; i < N; i++){
-    uint64_t halvedColumn = compress_right(state[i], 0x5555555555555555ULL);
-    halvedColumn |= halvedColumn << N/2;
-    result.state[i] = halvedColumn;
+  LifeState result(InitializedTag::UNINITIALIZED);
+  compress_right(state, result.state, N, 0x5555555555555555ULL);
+  for(int i = 0; i < N; i++)
+    result.state[i] |= result.state[i] << N/2;
+  return result;
+}
+
+inline LifeState LifeState::Double() const {
+  uint64_t folded[N/2];
+  for (int i = 0; i < N/2; i++) {
+    uint64_t column = state[i] | state[i + N/2];
+    folded[i] = (column | column >> N/2) & 0xFFFFFFFFULL;
   }
+  uint64_t doubled[N/2];
+  expand_right(folded, doubled, N/2, 0x5555555555555555ULL);
+
+  LifeState result;
+  for (int i = 0; i < N/2; i++)
+    result.state[2*i] = doubled[i];
+  return result;
+}
+
+inline LifeState LifeState::DoubleX() const {
+  LifeState result;
+  for (int i = 0; i < N/2; i++)
+    result.state[2*i] = state[i] | state[i + N/2];
+  return result;
+}
+
+inline LifeState LifeState::DoubleY() const {
+  LifeState result(InitializedTag::UNINITIALIZED);
+  for (int i = 0; i < N; i++)
+    result.state[i] = (state[i] | state[i] >> N/2) & 0xFFFFFFFFULL;
+  expand_right(result.state, result.state, N, 0x5555555555555555ULL);
   return result;
 }
 
@@ -726,6 +765,67 @@ inline LifeState LifeState::InvSkew() const {
   return result;
 }
 
+// The copy turned by 180 degrees in a C4 symmetric pattern is at
+// (x - y, x + y) for offset (x, y), so this pulls the C2 offsets back
+// through that map: the result has (x, y) if `c2offsets` has (x - y, x + y)
+inline LifeState C4DoubledOffsets(const LifeState &c2offsets) {
+  // (a, y) is (a, a + 2y) of the C2 offsets
+  LifeState result = c2offsets.InvSkew().HalveY();
+  // Then (x, y) is (x - y, y) of that
+  result.Transpose(false);
+  result = result.Skew();
+  result.Transpose(false);
+  return result;
+}
+
+// The rotations of a D8 symmetric pattern with offset (x, y) are those
+// of the C4 one with offset ((x + y) / 2, (y - x) / 2), so this pushes
+// the C4 offsets forward: the result has (a - b, a + b) if `c4offsets`
+// has (a, b)
+inline LifeState D8RotationOffsets(const LifeState &c4offsets) {
+  // (a, b) to (a, a + b)
+  LifeState result = c4offsets.Skew();
+  // Then (c, a) to (c, 2a - c)
+  result.Transpose(false);
+  result = result.DoubleY().InvSkew();
+  result.Transpose(false);
+  return result;
+}
+
+// For the D4diag reflections, which only see the part of the offset
+// perpendicular to their mirror. As `PerpComponent` works on the centred
+// offset this isn't periodic on the torus, so it is built column by
+// column rather than with `Skew`.
+inline LifeState D4diagReflectionOffsets(const LifeState &diag, const LifeState &antidiag) {
+  // By x - y + 63 and x + y + 64, over centred x and y
+  std::array<uint64_t, 128> acrossDiag{};
+  std::array<uint64_t, 128> acrossAntidiag{};
+  for (int j = -63; j <= 63; j++)
+    acrossDiag[j + 63] = diag.Get(((j + 128) / 2) % 64, ((-j + 128) / 2) % 64);
+  for (int s = -64; s <= 62; s++)
+    acrossAntidiag[s + 64] = antidiag.Get(((s + 128) / 2) % 64, ((s + 128) / 2) % 64);
+
+  // Bit r of each column is centred y = r - 32, starting from x = -32
+  uint64_t diagColumn = 0;
+  uint64_t antidiagColumn = 0;
+  for (int r = 0; r < 64; r++) {
+    diagColumn |= acrossDiag[63 - r] << r;
+    antidiagColumn |= acrossAntidiag[r] << r;
+  }
+
+  LifeState result;
+  for (int x = -32; x < 32; x++) {
+    result[torus_wrap(x)] = std::rotl(diagColumn | antidiagColumn, 32);
+    if (x == 31)
+      break;
+    diagColumn = (diagColumn << 1) | acrossDiag[x + 96];
+    antidiagColumn = (antidiagColumn >> 1) | (acrossAntidiag[x + 96] << 63);
+  }
+  return result;
+}
+
+// Offsets at which some other copy of `pat1` in the symmetric pattern
+// overlaps `pat2`
 inline LifeState IntersectingOffsets(const LifeState &pat1, const LifeState &pat2,
                               StaticSymmetry sym) {
     using enum SymmetryTransform;
@@ -736,15 +836,17 @@ inline LifeState IntersectingOffsets(const LifeState &pat1, const LifeState &pat
     case StaticSymmetry::C4: {
       transformed = pat1;
       transformed.Transform(Rotate270);
+      LifeState result = pat2.Convolve(transformed);
+
+      // The copy turned by 270 hits `pat2` where `pat2` turned by 90
+      // hits `pat1`, which is the same thing when they are equal
+      if (pat1 != pat2) {
+        transformed = pat2;
+        transformed.Transform(Rotate270);
+        result |= pat1.Convolve(transformed);
+      }
 
-      // // Very inefficient
-      // LifeState doubledcollisions = pat2.Convolve(pat1);
-      // doubledcollisions.Transform(ReflectAcrossYeqNegXP1);
-      // doubledcollisions = doubledcollisions.Skew().HalveY();
-      // doubledcollisions.Transform(ReflectAcrossYeqNegXP1);
-      // doubledcollisions = doubledcollisions.InvSkew();
-
-      return pat2.Convolve(transformed); // | doubledcollisions;
+      return result | C4DoubledOffsets(pat2.Convolve(pat1));
     }
     case StaticSymmetry::D2AcrossX:
       transformed = pat1;
@@ -762,6 +864,26 @@ inline LifeState IntersectingOffsets(const LifeState &pat1, const LifeState &pat
       transformed = pat1;
       transformed.Transform(ReflectAcrossYeqX);
       return pat2.Convolve(transformed);
+    case StaticSymmetry::D4: {
+      // Each reflection only sees its own component of the offset
+      LifeState acrossX = IntersectingOffsets(pat1, pat2, StaticSymmetry::D2AcrossX);
+      LifeState acrossY = IntersectingOffsets(pat1, pat2, StaticSymmetry::D2AcrossY);
+      LifeState result = pat2.Convolve(pat1);
+      for (int i = 0; i < N; i++)
+        result[i] |= acrossX[0] | (0 - (acrossY[i] & 1));
+      return result;
+    }
+    case StaticSymmetry::D4diag: {
+      LifeState diag = IntersectingOffsets(pat1, pat2, StaticSymmetry::D2diagodd);
+      LifeState antidiag = IntersectingOffsets(pat1, pat2, StaticSymmetry::D2negdiagodd);
+      return pat2.Convolve(pat1) | D4diagReflectionOffsets(diag, antidiag);
+    }
+    case StaticSymmetry::D8:
+      // The reflections are those of D4 and D4diag at the same offset,
+      // but the rotations are centred where C4's are at another one
+      return D8RotationOffsets(IntersectingOffsets(pat1, pat2, StaticSymmetry::C4)) |
+             IntersectingOffsets(pat1, pat2, StaticSymmetry::D4) |
+             IntersectingOffsets(pat1, pat2, StaticSymmetry::D4diag);
     default:
       __builtin_unreachable();
     }
@@ -771,14 +893,21 @@ inline LifeState IntersectingOffsets(const LifeState &active, StaticSymmetry sym
   return IntersectingOffsets(active, active, sym);
 }
 
-uint64_t LifeState::GetOctoHash() const {
-    uint64_t result = 0;
+inline uint64_t LifeState::GetOctoHash() const {
+    // `allTransforms` lists some transforms several times over (the
+    // Even/Odd variants), so XORing over it cancels out, and symmetric
+    // patterns would all XOR to 0 anyway. Take the minimum over the
+    // eight distinct ones instead.
+    uint64_t result = std::numeric_limits<uint64_t>::max();
 
-    for (auto t : allTransforms) {
+    using enum SymmetryTransform;
+    for (auto t :
+         {Identity, ReflectAcrossX, ReflectAcrossYeqX, ReflectAcrossY,
+          ReflectAcrossYeqNegXP1, Rotate90, Rotate270, Rotate180OddBoth}) {
       LifeState transformed = Transformed(t);
       auto [x, y,_x2, y2] = transformed.XYBounds();
       transformed.Move(-x, -y);
-      result ^= transformed.GetHash();
+      result = std::min(result, transformed.GetHash());
     }
 
     return result;
@@ -795,8 +924,8 @@ inline LifeState LifeState::MatchesLiveAndDeadSym(const LifeState &live, const L
     return result;
   }
 
-inline std::vector<LifeState> LifeState::SymmetryOrbit() const {
-  std::vector<LifeState> result;
+inline StaticVector<LifeState, 8> LifeState::SymmetryOrbit() const {
+  StaticVector<LifeState, 8> result;
   using enum SymmetryTransform;
   for (auto t :
        {Identity, ReflectAcrossX, ReflectAcrossYeqX, ReflectAcrossY,
@@ -811,9 +940,9 @@ inline std::vector<LifeState> LifeState::SymmetryOrbit() const {
   return result;
 }
 
-inline std::vector<SymmetryTransform> LifeState::SymmetryOrbitRepresentatives() const {
-  std::vector<LifeState> seen;
-  std::vector<SymmetryTransform> transforms;
+inline StaticVector<SymmetryTransform, 8> LifeState::SymmetryOrbitRepresentatives() const {
+  StaticVector<LifeState, 8> seen;
+  StaticVector<SymmetryTransform, 8> transforms;
   using enum SymmetryTransform;
   for (auto t :
        {Identity, ReflectAcrossX, ReflectAcrossYeqX, ReflectAcrossY,
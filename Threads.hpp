@@ -0,0 +1,36 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <thread>
+#include <vector>
+
+// The thread pools of the parallel searches. Every search takes a
+// `threads` parameter where 0 means one per core.
+
+inline unsigned ThreadCount(unsigned threads) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  return threads;
+}
+
+// Runs `worker` on `threads` threads (but never more than there are
+// `jobs`) and waits for all of them. A single worker runs on the calling
+// thread.
+template <typename F>
+void RunWorkers(unsigned threads, F worker,
+                size_t jobs = std::numeric_limits<size_t>::max()) {
+  threads = std::min<size_t>(ThreadCount(threads), jobs);
+
+  if (threads <= 1) {
+    worker();
+    return;
+  }
+
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < threads; t++)
+    pool.emplace_back(worker);
+  for (auto &thread : pool)
+    thread.join();
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../LifeAPI.hpp"
+#include "../LifeStable.hpp"
+#include "../LifeWeld.hpp"
+
+// Boards shared by the benchmarks. Everything is built from fixed seeds
+// so that results can be compared between runs.
+
+struct Board {
+  std::string name;
+  LifeState state;
+};
+
+inline const std::vector<Board> &Boards() {
+  static const std::vector<Board> boards = []() {
+    PRNG::Xoshiro256x4 generator(1);
+
+    LifeState soup = LifeState::RandomState(generator) & LifeState::SolidRect(-8, -8, 16, 16);
+
+    // What is left of a larger soup after it settles
+    LifeState ash = LifeState::RandomState(generator) & LifeState::SolidRect(-16, -16, 32, 32);
+    ash.Step(1000);
+
+    return std::vector<Board>{
+        {"sparse", LifeState::RandomState(generator, 0.05)},
+        {"dense", LifeState::RandomState(generator)},
+        {"still-lifes", ash},
+        {"soup", soup},
+    };
+  }();
+  return boards;
+}
+
+// Stator completions that CompleteStable finds hard, from the LifeWeld
+// tests. Each is the cells that must be kept, and the area they have to
+// be completed in.
+inline const std::vector<std::pair<std::string, LifeStable>> &StatorCorpus() {
+  static const std::vector<std::pair<std::string, LifeStable>> corpus = []() {
+    std::vector<std::pair<std::string, LifeState>> required = {
+      {"eater",
+       LifeState::ConstantParse("2b2o$bobo$bo$2o!")},
+      {"stator-a",
+       LifeState::ConstantParse("2o$o2bob2o$b3obobo$5bobo$b5ob3o$bo4bo3bo$4bobo2b2o$4b2o!")},
+      {"stator-b",
+       LifeState::ConstantParse("4b2ob2o$3bobobobo$b3o3bobo$o4bobob3o$b3ob2obo3bo$3bo4bo2b2o$5b3o$4b2o!")},
+    };
+    std::vector<LifeState> masks = {
+      LifeState::ConstantParse("2b2o$b3o$b4o$5o$4o$4o!").Moved(-1, -1),
+      LifeState::ConstantParse("4o$5o2bo$4o$5o4bo$b5ob5o$b12o$b12o$b12o$4b9o$4b4o!").Moved(-1, -1),
+      LifeState::ConstantParse("4b2o$3b2o2bo2b2o$b4o6bo$6obob5o$15o$15o$b14o$3b12o$4b6o$4b4o!").Moved(-1, -1),
+    };
+
+    std::vector<std::pair<std::string, LifeStable>> result;
+    for (unsigned i = 0; i < required.size(); i++)
+      result.push_back({required[i].first, LifeWeld::FromRequired(required[i].second, masks[i]).ToStable()});
+    return result;
+  }();
+  return corpus;
+}
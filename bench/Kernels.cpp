@@ -0,0 +1,200 @@
+// LifeState and LifeWeld kernels over each of the boards in Fixtures.hpp
+
+#include <benchmark/benchmark.h>
+
+#include "../LifeAPI.hpp"
+#include "../LifeWeld.hpp"
+#include "../NeighbourCount.hpp"
+#include "../RunUntil.hpp"
+#include "../Symmetry.hpp"
+#include "Fixtures.hpp"
+
+const LifeState eater = LifeState::ConstantParse("2b2o$bobo$bo$2o!");
+const LifeState block = LifeState::ConstantParse("2o$2o!");
+
+const Board &GetBoard(benchmark::State &state) {
+  const Board &board = Boards()[state.range(0)];
+  state.SetLabel(board.name);
+  return board;
+}
+
+void BoardArgs(benchmark::internal::Benchmark *b) {
+  b->ArgName("board")->DenseRange(0, Boards().size() - 1);
+}
+
+static void BM_Step(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  for (auto _ : state) {
+    LifeState current = board.state;
+    current.Step();
+    benchmark::DoNotOptimize(current);
+  }
+}
+BENCHMARK(BM_Step)->Apply(BoardArgs);
+
+static void BM_StepAlt(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  for (auto _ : state) {
+    LifeState current = board.state;
+    current.StepAlt();
+    benchmark::DoNotOptimize(current);
+  }
+}
+BENCHMARK(BM_StepAlt)->Apply(BoardArgs);
+
+static void BM_Convolve(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  LifeState mirrored = eater.Mirrored();
+  for (auto _ : state)
+    benchmark::DoNotOptimize(board.state.Convolve(mirrored));
+}
+BENCHMARK(BM_Convolve)->Apply(BoardArgs);
+
+static void BM_InteractionOffsets(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(board.state.InteractionOffsets(eater));
+}
+BENCHMARK(BM_InteractionOffsets)->Apply(BoardArgs);
+
+static void BM_Match(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(board.state.Match(block));
+}
+BENCHMARK(BM_Match)->Apply(BoardArgs);
+
+static void BM_Transform(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  for (auto _ : state) {
+    for (auto t : allTransforms)
+      benchmark::DoNotOptimize(board.state.Transformed(t));
+  }
+  state.SetItemsProcessed(state.iterations() * std::size(allTransforms));
+}
+BENCHMARK(BM_Transform)->Apply(BoardArgs);
+
+static void BM_GetOctoHash(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(board.state.GetOctoHash());
+}
+BENCHMARK(BM_GetOctoHash)->Apply(BoardArgs);
+
+// Every "exactly n" mask of a board's neighbour counts
+static void BM_WithExactly(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  NeighbourCount counts(board.state);
+  for (auto _ : state) {
+    for (unsigned n = 0; n < NeighbourClasses::count; n++)
+      benchmark::DoNotOptimize(counts.WithExactly(n));
+  }
+}
+BENCHMARK(BM_WithExactly)->Apply(BoardArgs);
+
+static void BM_Classes(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  NeighbourCount counts(board.state);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(counts.Classes());
+}
+BENCHMARK(BM_Classes)->Apply(BoardArgs);
+
+static void BM_LifeWeldStep(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  // Frozen counts on the left half, so adding them in is measured too
+  LifeState left = LifeState::SolidRect(0, 0, 32, 64);
+  LifeWeld weld(board.state & ~left, board.state & left, LifeState(), LifeState());
+  for (auto _ : state) {
+    LifeWeld current = weld;
+    current.Step();
+    benchmark::DoNotOptimize(current);
+  }
+}
+BENCHMARK(BM_LifeWeldStep)->Apply(BoardArgs);
+
+static void BM_Cells(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  for (auto _ : state) {
+    for (auto cell : board.state.Cells())
+      benchmark::DoNotOptimize(cell);
+  }
+  state.SetItemsProcessed(state.iterations() * board.state.GetPop());
+}
+BENCHMARK(BM_Cells)->Apply(BoardArgs);
+
+// OR in a moved copy of the board, as the placement loops do
+static void BM_Moved(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  LifeState result;
+  int offset = 0;
+  for (auto _ : state) {
+    offset++;
+    result |= board.state.Moved(offset, 2 * offset);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_Moved)->Apply(BoardArgs);
+
+static void BM_Translated(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  LifeState result;
+  int offset = 0;
+  for (auto _ : state) {
+    offset++;
+    result |= Translated(board.state, offset, 2 * offset);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_Translated)->Apply(BoardArgs);
+
+static void BM_HalveY(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(board.state.HalveY());
+}
+BENCHMARK(BM_HalveY)->Apply(BoardArgs);
+
+static void BM_DoubleY(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(board.state.DoubleY());
+}
+BENCHMARK(BM_DoubleY)->Apply(BoardArgs);
+
+static void BM_IntersectingOffsetsC4(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  LifeState active = board.state & LifeState::SolidRect(-8, -8, 16, 16);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(IntersectingOffsets(active, StaticSymmetry::C4));
+}
+BENCHMARK(BM_IntersectingOffsetsC4)->Apply(BoardArgs);
+
+// 32 generations checking population, a forbidden zone and stability,
+// as a candidate filter would
+static void BM_RunSeparate(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  LifeState forbidden = LifeState::SolidRect(30, 30, 2, 2);
+  for (auto _ : state) {
+    LifeState current = board.state;
+    for (unsigned gen = 1; gen <= 32; gen++) {
+      LifeState previous = current;
+      current.Step();
+      if (current.GetPop() > 4000 || !(current & forbidden).IsEmpty() || current == previous)
+        break;
+    }
+    benchmark::DoNotOptimize(current);
+  }
+}
+BENCHMARK(BM_RunSeparate)->Apply(BoardArgs);
+
+static void BM_RunUntil(benchmark::State &state) {
+  const Board &board = GetBoard(state);
+  LifeState forbidden = LifeState::SolidRect(30, 30, 2, 2);
+  for (auto _ : state) {
+    LifeState current = board.state;
+    RunUntil(current, 32, PopulationAbove{4000}, TouchesCells{forbidden}, Stabilised<1>{});
+    benchmark::DoNotOptimize(current);
+  }
+}
+BENCHMARK(BM_RunUntil)->Apply(BoardArgs);
@@ -0,0 +1,60 @@
+// LifeStable propagation and completion over the stator corpus in
+// Fixtures.hpp. CompleteStable is run with every BranchHeuristic and
+// reports the search nodes and completed population as counters.
+
+#include <benchmark/benchmark.h>
+
+#include "../LifeAPI.hpp"
+#include "../LifeStable.hpp"
+#include "Fixtures.hpp"
+
+const std::pair<std::string, LifeStable> &GetProblem(benchmark::State &state) {
+  return StatorCorpus()[state.range(0)];
+}
+
+void CorpusArgs(benchmark::internal::Benchmark *b) {
+  b->ArgName("problem")->DenseRange(0, StatorCorpus().size() - 1);
+}
+
+static void BM_Propagate(benchmark::State &state) {
+  auto &[name, problem] = GetProblem(state);
+  state.SetLabel(name);
+  for (auto _ : state) {
+    LifeStable current = problem;
+    benchmark::DoNotOptimize(current.Propagate());
+  }
+}
+BENCHMARK(BM_Propagate)->Apply(CorpusArgs);
+
+const std::vector<std::pair<std::string, BranchHeuristic>> heuristics = {
+  {"default", BranchHeuristic::DEFAULT},
+  {"most-constrained", BranchHeuristic::MOST_CONSTRAINED},
+  {"activity", BranchHeuristic::ACTIVITY},
+  {"seed-distance", BranchHeuristic::SEED_DISTANCE},
+};
+
+static void BM_CompleteStable(benchmark::State &state) {
+  auto &[name, problem] = GetProblem(state);
+  auto &[heuristicName, heuristic] = heuristics[state.range(1)];
+  state.SetLabel(name + "/" + heuristicName);
+
+  uint64_t nodes = 0;
+  LifeStable::CompletionResult result = LifeStable::CompletionResult::TIMEOUT;
+  LifeState completion;
+  for (auto _ : state) {
+    LifeStable current = problem;
+    std::tie(result, completion) = current.CompleteStable(10, true, false, LifeState(), nullptr, heuristic, &nodes);
+  }
+
+  state.counters["nodes"] = nodes;
+  state.counters["population"] = completion.GetPop();
+  state.counters["completed"] = result == LifeStable::CompletionResult::COMPLETED;
+}
+BENCHMARK(BM_CompleteStable)
+    ->ArgNames({"problem", "heuristic"})
+    ->ArgsProduct({benchmark::CreateDenseRange(0, StatorCorpus().size() - 1, 1),
+                   benchmark::CreateDenseRange(0, heuristics.size() - 1, 1)})
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include "../LifeAPI.hpp"
+#include "../CatalystSearch.hpp"
+
+const std::string eaterLibrary =
+  "# name maxRecovery rle\n"
+  "\n"
+  "eater 20 2.2D$.2DCA$.DCDC$2DC2D$D2CD$4D!\n";
+
+TEST(CatalystSearchTest, ParseLibrary) {
+  auto library = ParseCatalystLibrary(eaterLibrary);
+  ASSERT_EQ(library.size(), 1u);
+  EXPECT_EQ(library[0].name, "eater");
+  EXPECT_EQ(library[0].maxRecovery, 20u);
+
+  LifeWeld expected = LifeWeld::FromRequired(
+      LifeState::ConstantParse("2b2o$bobo$bo$2o!"),
+      LifeState::ConstantParse("2b2o$b3o$b4o$5o$4o$4o!").Moved(-1, -1));
+  EXPECT_EQ(library[0].weld.state.GetOctoHash(), expected.state.GetOctoHash());
+  EXPECT_EQ(library[0].Orientations().size(), 8u);
+}
+
+TEST(CatalystSearchTest, EaterEatsGlider) {
+  auto library = ParseCatalystLibrary(eaterLibrary);
+  LifeState glider = LifeState::ConstantParse("bo$2bo$3o!");
+
+  CatalystSearchParams params;
+  params.maxGeneration = 60;
+  params.threads = 1;
+  CatalystSearch serial(glider, library, params);
+  params.threads = 4;
+  params.batchSize = 7;
+  CatalystSearch parallel(glider, library, params);
+
+  CatalystSearchStats stats;
+  auto solutions = parallel.Run(&stats);
+  auto serialSolutions = serial.Run();
+
+  EXPECT_FALSE(solutions.empty());
+  EXPECT_GT(stats.candidates, solutions.size());
+  EXPECT_EQ(stats.solutions, solutions.size());
+  ASSERT_EQ(solutions.size(), serialSolutions.size());
+
+  std::unordered_set<uint64_t> hashes;
+  for (unsigned i = 0; i < solutions.size(); i++) {
+    auto &solution = solutions[i];
+    EXPECT_EQ(solution.placement, serialSolutions[i].placement);
+    EXPECT_TRUE(hashes.insert(solution.hash).second);
+    EXPECT_LT(solution.interaction, solution.recovery);
+
+    // The catalyst is back afterwards
+    const Catalyst &catalyst = library[solution.placement.catalyst];
+    LifeWeld placed = catalyst.weld.Transformed(solution.placement.transform).Moved(solution.placement.offset);
+    LifeWeld replay = placed;
+    replay.state |= glider;
+    replay.Step(solution.recovery + params.recoveredFor);
+    EXPECT_TRUE(replay.state.Contains(placed.ToTarget()));
+  }
+}
+
+TEST(CatalystSearchTest, MirrorImagesMerged) {
+  auto library = ParseCatalystLibrary(eaterLibrary);
+  const SymmetryTransform mirror = SymmetryTransform::ReflectAcrossY;
+
+  // Two gliders flying apart, each the mirror image of the other
+  LifeState glider = LifeState::ConstantParse("bo$2bo$3o!").Moved(10, 0);
+  LifeState reaction = glider | glider.Transformed(mirror);
+  ASSERT_EQ(reaction.Transformed(mirror), reaction);
+
+  CatalystSearchParams params;
+  params.maxGeneration = 60;
+  params.threads = 1;
+  CatalystSearch search(reaction, library, params);
+  auto solutions = search.Run();
+  ASSERT_FALSE(solutions.empty());
+
+  for (auto &solution : solutions) {
+    const Catalyst &catalyst = library[solution.placement.catalyst];
+    LifeWeld placed = catalyst.weld.Transformed(solution.placement.transform).Moved(solution.placement.offset);
+    LifeWeld mirrored = placed.Transformed(mirror);
+
+    // The eater's live cells look the same in several orientations, so
+    // the frozen cells have to match as well
+    std::optional<CatalystPlacement> image;
+    auto [mx, my] = mirrored.state.FirstOn();
+    for (auto t : catalyst.Orientations()) {
+      LifeWeld oriented = catalyst.weld.Transformed(t);
+      for (auto [ox, oy] : oriented.state.OnCells()) {
+        std::pair<int, int> offset = {torus_wrap(mx - ox), torus_wrap(my - oy)};
+        if (oriented.Moved(offset) == mirrored)
+          image = CatalystPlacement{solution.placement.catalyst, t, offset};
+      }
+    }
+    ASSERT_TRUE(image.has_value());
+    ASSERT_NE(*image, solution.placement);
+
+    // The image works just as well and collides in the same way, but
+    // only one of the two is reported
+    auto imageSolution = search.Test(*image);
+    ASSERT_TRUE(imageSolution.has_value());
+    EXPECT_EQ(imageSolution->hash, solution.hash);
+    for (auto &other : solutions)
+      EXPECT_NE(other.placement, *image);
+  }
+}
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include "../LifeAPI.hpp"
+#include "../Parsing.hpp"
+#include "../Census.hpp"
+
+TEST(CensusTest, BoundedQueue) {
+  BoundedQueue<int> queue(2);
+  std::thread producer([&]() {
+    for (int i = 0; i < 10; i++)
+      EXPECT_TRUE(queue.Push(i));
+    queue.Close();
+  });
+
+  std::vector<int> received;
+  while (auto item = queue.Pop())
+    received.push_back(*item);
+  producer.join();
+
+  ASSERT_EQ(received.size(), 10u);
+  for (int i = 0; i < 10; i++)
+    EXPECT_EQ(received[i], i);
+  EXPECT_FALSE(queue.Push(10));
+}
+
+TEST(CensusTest, SoupsAreReproducible) {
+  CensusParams params;
+  params.seed = 5;
+  Census census(params);
+
+  EXPECT_EQ(census.Soup(3), Census(params).Soup(3));
+  EXPECT_NE(census.Soup(3), census.Soup(4));
+  EXPECT_TRUE((census.Soup(3) & ~LifeState::SolidRect(-8, -8, 16, 16)).IsEmpty());
+}
+
+TEST(CensusTest, ThreadsAgree) {
+  CensusParams params;
+  params.soups = 100;
+  params.threads = 1;
+  auto serial = Census(params).Run();
+  params.threads = 3;
+  params.batchSize = 3;
+  auto parallel = Census(params).Run();
+
+  EXPECT_EQ(serial.soups, 100u);
+  EXPECT_EQ(parallel.unsettled, serial.unsettled);
+  ASSERT_EQ(parallel.objects.size(), serial.objects.size());
+  for (auto &[hash, entry] : serial.objects)
+    EXPECT_EQ(parallel.objects[hash].count, entry.count);
+
+  // Blocks and blinkers are always the most common
+  auto sorted = serial.Sorted();
+  ASSERT_GE(sorted.size(), 2u);
+  std::vector<uint64_t> top = {sorted[0].first, sorted[1].first};
+  EXPECT_NE(std::find(top.begin(), top.end(), CollisionEnumerator::CanonicalHash(LifeState::ConstantParse("2o$2o!"))), top.end());
+  EXPECT_NE(std::find(top.begin(), top.end(), CollisionEnumerator::CanonicalHash(LifeState::ConstantParse("3o!"))), top.end());
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include "../LifeAPI.hpp"
+#include "../Parsing.hpp"
+#include "../Collision.hpp"
+
+const LifeState block = LifeState::ConstantParse("2o$2o!");
+const LifeState glider = LifeState::ConstantParse("bo$2bo$3o!");
+
+TEST(CollisionTest, GliderDirection) {
+  EXPECT_EQ(CollisionEnumerator::GliderDirection(glider), std::make_pair(1, 1));
+  EXPECT_EQ(CollisionEnumerator::GliderDirection(glider.Transformed(SymmetryTransform::Rotate90)),
+            std::make_pair(-1, 1));
+  EXPECT_FALSE(CollisionEnumerator::GliderDirection(block));
+  EXPECT_FALSE(CollisionEnumerator::GliderDirection(LifeState::ConstantParse("2o$obo$bo!")));
+}
+
+TEST(CollisionTest, GliderBlock) {
+  CollisionEnumerator enumerator(block, glider);
+
+  CollisionStats stats;
+  auto results = enumerator.Run(&stats);
+
+  // One per lane, up to the diagonal reflection of the block
+  ASSERT_EQ(results.size(), 6u);
+  EXPECT_GT(stats.candidates, results.size());
+  EXPECT_EQ(stats.settled, 6u);
+
+  unsigned annihilations = 0;
+  unsigned blocks = 0;
+  std::unordered_set<uint64_t> hashes;
+  for (auto &result : results) {
+    EXPECT_TRUE(hashes.insert(result.hash).second);
+    EXPECT_TRUE(result.settled);
+    EXPECT_EQ(result.debris.Stepped(result.period), result.debris);
+    if (result.products.empty() && result.gliders.empty())
+      annihilations++;
+    if (result.products == std::vector<uint64_t>{CollisionEnumerator::CanonicalHash(block)})
+      blocks++;
+  }
+  EXPECT_EQ(annihilations, 3u);
+  EXPECT_EQ(blocks, 1u);
+}
+
+TEST(CollisionTest, GliderGlider) {
+  CollisionParams params;
+  params.threads = 1;
+  auto serial = CollisionEnumerator(glider, glider, params).Run();
+  params.threads = 4;
+  params.batchSize = 5;
+  auto parallel = CollisionEnumerator(glider, glider, params).Run();
+
+  ASSERT_EQ(serial.size(), 71u);
+  ASSERT_EQ(parallel.size(), serial.size());
+
+  unsigned withGliders = 0;
+  for (unsigned i = 0; i < serial.size(); i++) {
+    EXPECT_EQ(parallel[i].placement, serial[i].placement);
+    EXPECT_EQ(parallel[i].products, serial[i].products);
+    EXPECT_EQ(parallel[i].gliders.size(), serial[i].gliders.size());
+
+    for (auto &emitted : serial[i].gliders) {
+      EXPECT_EQ(std::abs(emitted.direction.first), 1);
+      EXPECT_EQ(std::abs(emitted.direction.second), 1);
+    }
+    if (!serial[i].gliders.empty())
+      withGliders++;
+  }
+  EXPECT_GT(withGliders, 0u);
+}
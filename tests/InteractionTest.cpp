@@ -26,6 +26,27 @@ TEST(InteractionTest, EaterSelfInteractionTest) {
   }
 }
 
+TEST(InteractionTest, ActiveInteractionTest) {
+  LifeState glider = LifeState::ConstantParse("bo$2bo$3o!");
+  LifeState blinker = LifeState::ConstantParse("3o!");
+
+  for (auto [a, b] : {std::make_pair(glider, glider), std::make_pair(glider, blinker),
+                      std::make_pair(blinker, glider.Stepped())}) {
+    LifeState offsets = a.InteractionOffsets(b);
+    for (int i = -10; i < 10; i++) {
+      for (int j = -10; j < 10; j++) {
+        LifeState moved = b.Moved(i, j);
+        if (!(a & moved).IsEmpty())
+          continue;
+
+        LifeState together = a | moved;
+        bool interacts = together.Stepped() != (a.Stepped() | moved.Stepped());
+        EXPECT_EQ(offsets.GetSafe(i, j), interacts) << "At offset (" << i << ", " << j << "): " << together;
+      }
+    }
+  }
+}
+
 void TestInteractionCounts(LifeState state) {
   LifeState bit3(UNINITIALIZED), bit2(UNINITIALIZED), bit1(UNINITIALIZED), bit0(UNINITIALIZED);
   state.CountNeighbourhood(bit3, bit2, bit1, bit0);
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include "../LifeAPI.hpp"
+#include "../LifeHistory.hpp"
+
+TEST(LifeHistoryTest, StepMatchesSeparatePasses) {
+  PRNG::Xoshiro256x4 generator(12);
+  LifeState start = LifeState::RandomState(generator, 0.3) & LifeState::SolidRect(-8, -8, 16, 16);
+
+  LifeHistory fused(start, start);
+  fused.Step(30);
+
+  LifeState state = start;
+  LifeState history = start;
+  for (unsigned i = 0; i < 30; i++) {
+    state.Step();
+    history |= state;
+  }
+
+  EXPECT_EQ(fused.state, state);
+  EXPECT_EQ(fused.history, history);
+}
+
+TEST(LifeHistoryTest, StepUntilMarked) {
+  // A glider heading towards a marked cell ahead of it
+  LifeState glider = LifeState::ConstantParse("bo$2bo$3o!");
+  LifeHistory pattern(glider, glider, LifeState::Cell({10, 10}));
+
+  LifeHistory expected = pattern;
+  unsigned gen = 0;
+  while (!expected.state.Get(10, 10)) {
+    expected.Step();
+    gen++;
+  }
+
+  auto hit = pattern.StepUntilMarked(100);
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_EQ(hit->generation, gen);
+  EXPECT_EQ(hit->cell, std::make_pair(10, 10));
+  EXPECT_EQ(pattern.state, expected.state);
+  EXPECT_EQ(pattern.history, expected.history);
+
+  LifeHistory away(glider, glider, LifeState::Cell({-10, -10}));
+  EXPECT_FALSE(away.StepUntilMarked(20).has_value());
+}
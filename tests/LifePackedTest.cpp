@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include "../LifeAPI.hpp"
+#include "../Parsing.hpp"
+#include "../LifePacked.hpp"
+#include "../Collision.hpp"
+
+const LifeState eater = LifeState::ConstantParse("2o$obo$2bo$2b2o!");
+
+TEST(LifePackedTest, RoundTrip) {
+  LifeState placed = eater.Moved(-10, 5);
+
+  std::pair<int, int> origin;
+  auto packed = LifeStatePacked<4, 4>::Cropped(placed, &origin);
+  ASSERT_TRUE(packed);
+  EXPECT_EQ(sizeof(packed->columns), 4u);
+  EXPECT_EQ(origin, std::make_pair(-10, 5));
+  EXPECT_EQ(packed->ToState(origin), placed);
+  EXPECT_EQ(packed->ToState(), eater);
+  EXPECT_EQ(packed->GetPop(), eater.GetPop());
+
+  EXPECT_FALSE((LifeStatePacked<3, 8>::Cropped(placed)));
+
+  LifeStatePackedDynamic dynamic(placed, &origin);
+  EXPECT_EQ(dynamic.Width(), 4u);
+  EXPECT_EQ(dynamic.Height(), 4u);
+  EXPECT_EQ(dynamic.bits.size(), 1u);
+  EXPECT_EQ(dynamic.ToState(origin), placed);
+  EXPECT_EQ(dynamic.GetPop(), eater.GetPop());
+}
+
+TEST(LifePackedTest, DynamicAcrossWords) {
+  // 13 rows a column, so most columns straddle two words
+  PRNG::Xoshiro256x4 generator(9);
+  LifeState random = LifeState::RandomState(generator) & LifeState::SolidRect(-6, -6, 20, 13);
+  random.Set(torus_wrap(-6), torus_wrap(-6));
+  random.Set(13, 6);
+
+  std::pair<int, int> origin;
+  LifeStatePackedDynamic packed(random, &origin);
+  EXPECT_EQ(packed.Width(), 20u);
+  EXPECT_EQ(packed.Height(), 13u);
+  EXPECT_EQ(packed.bits.size(), 5u);
+  EXPECT_EQ(packed.ToState(origin), random);
+  for (unsigned x = 0; x < packed.Width(); x++)
+    for (unsigned y = 0; y < packed.Height(); y++)
+      EXPECT_EQ(packed.Get(x, y), random.GetSafe(origin.first + x, origin.second + y));
+}
+
+TEST(LifePackedTest, ContainsMatchesFull) {
+  auto packed = *LifeStatePacked<4, 4>::Cropped(eater);
+  LifeStatePackedDynamic dynamic(eater);
+  LifeState big = LifeState::ConstantParse("2o$obo$2bo$2b2o!").Moved(20, -30) | LifeState::SolidRect(-5, -5, 3, 3);
+
+  for (int x = 0; x < N; x++) {
+    for (int y = 0; y < N; y++) {
+      LifeState moved = eater.Moved(x, y);
+      EXPECT_EQ(big.Contains(packed, {x, y}), big.Contains(moved));
+      EXPECT_EQ(big.AreDisjoint(packed, {x, y}), big.AreDisjoint(moved));
+      EXPECT_EQ(big.Contains(dynamic, {x, y}), big.Contains(moved));
+      EXPECT_EQ(big.AreDisjoint(dynamic, {x, y}), big.AreDisjoint(moved));
+    }
+  }
+}
+
+TEST(LifePackedTest, CanonicalHash) {
+  auto packed = *LifeStatePacked<4, 4>::Cropped(eater);
+  for (auto t : {SymmetryTransform::Identity, SymmetryTransform::Rotate90, SymmetryTransform::ReflectAcrossX}) {
+    LifeState transformed = eater.Transformed(t).Moved(7, -12);
+    EXPECT_EQ(packed.GetOctoHash(), CollisionEnumerator::CanonicalHash(transformed));
+    EXPECT_EQ(LifeStatePackedDynamic(transformed).GetOctoHash(), packed.GetOctoHash());
+  }
+  EXPECT_EQ(LifeStatePackedDynamic(eater.Moved(3, 3)).GetHash(), LifeStatePackedDynamic(eater).GetHash());
+
+  // The largest box allowed, moved as far as it can go each way
+  LifeState big = LifeState::RandomState() & LifeState::SolidRect(0, 0, 32, 32);
+  big.Set(0, 0);
+  big.Set(31, 31);
+  LifeStatePacked<32, 32> bigPacked(big, {0, 0});
+  for (auto t : allTransforms) {
+    LifeState transformed = big.Transformed(t);
+    auto [x0, y0, x1, y1] = transformed.XYBounds();
+    for (auto [x, y] : std::vector<std::pair<int, int>>{{-31, -31}, {0, 0}, {-31, 0}, {-15, -7}})
+      EXPECT_EQ(transformed.Moved(x - x0, y - y0).GetOctoHash(), bigPacked.GetOctoHash());
+  }
+}
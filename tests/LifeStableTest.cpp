@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include "../LifeAPI.hpp"
+#include "../LifeStable.hpp"
+#include "../LifeWeld.hpp"
+
+LifeStable EaterProblem() {
+  LifeState eater = LifeState::ConstantParse("2b2o$bobo$bo$2o!");
+  LifeState required = LifeState::ConstantParse("2b2o$b3o$b4o$5o$4o$4o!").Moved(-1, -1);
+  return LifeWeld::FromRequired(eater, required).ToStable();
+}
+
+TEST(LifeStableTest, EnumerateStable) {
+  LifeStable problem = EaterProblem();
+
+  std::vector<LifeState> completions;
+  auto result = problem.EnumerateStable(10, 20, 10, [&](const LifeState &completion) {
+    completions.push_back(completion);
+  });
+
+  EXPECT_EQ(result, LifeStable::CompletionResult::COMPLETED);
+  EXPECT_FALSE(completions.empty());
+  EXPECT_LE(completions.size(), 10u);
+
+  for (unsigned i = 0; i < completions.size(); i++) {
+    const LifeState &completion = completions[i];
+    EXPECT_EQ(completion, completion.Stepped()) << completion;
+    EXPECT_TRUE(completion.Contains(problem.state)) << completion;
+    EXPECT_LE(completion.GetPop(), 20u);
+    for (unsigned j = 0; j < i; j++)
+      EXPECT_NE(completion, completions[j]);
+  }
+}
+
+TEST(LifeStableTest, EnumerateStableLimit) {
+  LifeStable problem = EaterProblem();
+
+  unsigned count = 0;
+  problem.EnumerateStable(10, 30, 3, [&](const LifeState &) { count++; });
+  EXPECT_EQ(count, 3u);
+}
+
+TEST(LifeStableTest, ConflictCacheLearnsOnlyConflicts) {
+  StableConflictCache cache;
+
+  // A live cell with every neighbour dead can't be stable
+  LifeStable lonely;
+  lonely.unknown = ~LifeState();
+  lonely.SetOff(LifeState::Cell({1, 1}).ZOI());
+  lonely.SetOn(std::make_pair(1, 1));
+  uint64_t lonelyKey = StableConflictCache::Key(lonely, {1, 1});
+  cache.Learn(lonelyKey);
+  EXPECT_TRUE(cache.IsConflict(lonelyKey));
+
+  LifeStable block;
+  block.unknown = ~LifeState();
+  block.SetOff(LifeState::Cell({1, 1}).BigZOI());
+  block.SetOn(LifeState::ConstantParse("2o$2o!").Moved(1, 1));
+  uint64_t blockKey = StableConflictCache::Key(block, {1, 1});
+  cache.Learn(blockKey);
+  EXPECT_FALSE(cache.IsConflict(blockKey));
+}
+
+TEST(LifeStableTest, ConflictCacheSameResult) {
+  LifeStable problem = EaterProblem();
+
+  auto [plainResult, plain] = problem.CompleteStable(10, true);
+
+  StableConflictCache cache;
+  for (unsigned i = 0; i < 2; i++) {
+    auto [cachedResult, cached] = problem.CompleteStable(10, true, false, LifeState(), &cache);
+    EXPECT_EQ(cachedResult, plainResult);
+    EXPECT_EQ(cached.GetPop(), plain.GetPop());
+    EXPECT_EQ(cached, cached.Stepped());
+  }
+}
+
+TEST(LifeStableTest, ConflictCacheWarmPrunes) {
+  LifeStable problem = EaterProblem();
+
+  StableConflictCache cache;
+  uint64_t coldNodes = 0;
+  uint64_t warmNodes = 0;
+  problem.CompleteStable(10, true, false, LifeState(), &cache, BranchHeuristic::DEFAULT, &coldNodes);
+  EXPECT_FALSE(cache.nogoods.empty());
+  problem.CompleteStable(10, true, false, LifeState(), &cache, BranchHeuristic::DEFAULT, &warmNodes);
+  EXPECT_LT(warmNodes, coldNodes);
+}
+
+TEST(LifeStableTest, BranchHeuristicsAgree) {
+  LifeStable problem = EaterProblem();
+
+  auto [expectedResult, expected] = problem.CompleteStable(10, true);
+
+  for (auto heuristic : {BranchHeuristic::MOST_CONSTRAINED, BranchHeuristic::ACTIVITY, BranchHeuristic::SEED_DISTANCE}) {
+    uint64_t nodes = 0;
+    auto [result, completion] = problem.CompleteStable(10, true, false, LifeState(), nullptr, heuristic, &nodes);
+    EXPECT_EQ(result, expectedResult);
+    EXPECT_EQ(completion.GetPop(), expected.GetPop());
+    EXPECT_EQ(completion, completion.Stepped());
+    EXPECT_GT(nodes, 0u);
+  }
+}
+
+TEST(LifeStableTest, CompleteStableSymmetric) {
+  using enum StaticSymmetry;
+  for (auto sym : {C2, C4, D2AcrossY, D4, D4diag, D8}) {
+    LifeState seed = LifeState::ConstantParse("2o$o!").Moved(30, 30);
+    LifeState on = Symmetricize(seed, sym, {0, 0});
+
+    LifeStable problem;
+    problem.unknown = ~LifeState();
+    problem.SetOn(on);
+
+    uint64_t nodes = 0;
+    auto [result, completion] = problem.CompleteStable(10, false, sym, {0, 0}, nullptr, &nodes);
+    ASSERT_EQ(result, LifeStable::CompletionResult::COMPLETED) << SymmetryToString(sym);
+    EXPECT_EQ(completion, completion.Stepped()) << SymmetryToString(sym) << completion;
+    EXPECT_EQ(Symmetricize(completion, sym, {0, 0}), completion) << SymmetryToString(sym) << completion;
+    EXPECT_TRUE(completion.Contains(on));
+    EXPECT_GT(nodes, 0u);
+  }
+}
+
+TEST(LifeStableTest, CompleteStableUnsupportedSymmetry) {
+  LifeStable problem;
+  problem.unknown = ~LifeState();
+  problem.SetOn(LifeState::ConstantParse("2o$o!").Moved(30, 30));
+
+  for (auto sym : {StaticSymmetry::C2even, StaticSymmetry::D8even}) {
+    auto [result, completion] = problem.CompleteStable(10, false, sym, {0, 0});
+    EXPECT_EQ(result, LifeStable::CompletionResult::INCONSISTENT) << SymmetryToString(sym);
+    EXPECT_FALSE(LifeStable(problem).Symmetricize(sym, {0, 0})) << SymmetryToString(sym);
+  }
+}
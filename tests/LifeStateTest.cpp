@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include "../LifeAPI.hpp"
+#include "../Parsing.hpp"
+
+TEST(LifeStateTest, CellsMatchGet) {
+  PRNG::Xoshiro256x4 generator(3);
+  for (double density : {0.0, 0.01, 0.5, 1.0}) {
+    LifeState state = LifeState::RandomState(generator, density);
+
+    std::vector<std::pair<int, int>> expected;
+    for (int x = 0; x < N; x++)
+      for (int y = 0; y < N; y++)
+        if (state.Get(x, y))
+          expected.push_back({x, y});
+
+    std::vector<std::pair<int, int>> cells;
+    for (auto cell : state.Cells())
+      cells.push_back(cell);
+
+    EXPECT_EQ(cells, expected) << density;
+    EXPECT_EQ(state.OnCells(), expected) << density;
+  }
+}
+
+TEST(LifeStateTest, CellsOfTemporary) {
+  LifeState block = LifeState::ConstantParse("2o$2o!");
+  LifeState result;
+  for (auto cell : (block | block.Moved(62, 62)).Cells())
+    result.Set(cell.first, cell.second);
+  EXPECT_EQ(result, block | block.Moved(62, 62));
+}
+
+TEST(LifeStateTest, TranslatedMatchesMoved) {
+  PRNG::Xoshiro256x4 generator(5);
+  LifeState a = LifeState::RandomState(generator, 0.5);
+  LifeState b = LifeState::RandomState(generator, 0.1);
+
+  for (auto [dx, dy] : std::vector<std::pair<int, int>>{{0, 0}, {3, -7}, {-40, 63}, {64, 1}}) {
+    LifeState moved = b.Moved(dx, dy);
+    Translated view(b, dx, dy);
+
+    EXPECT_EQ(a | view, a | moved);
+    EXPECT_EQ(a & view, a & moved);
+    EXPECT_EQ(a ^ view, a ^ moved);
+    EXPECT_TRUE(moved == view);
+    EXPECT_EQ(b == view, b == moved);
+
+    LifeState c = a;
+    c |= view;
+    EXPECT_EQ(c, a | moved);
+    EXPECT_TRUE(c.Contains(view));
+    EXPECT_TRUE((~c).AreDisjoint(view));
+    EXPECT_EQ(a.Contains(view), a.Contains(moved));
+
+    LifeState stepped;
+    stepped |= view.Stepped(3);
+    EXPECT_EQ(stepped, moved.Stepped(3));
+  }
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include "../LifeAPI.hpp"
+#include "../Parsing.hpp"
+#include "../LifeStrip.hpp"
+
+// Only the columns of the strip, so the strip's dead edges are right
+LifeState Isolated(const LifeState &state, unsigned column, unsigned width) {
+  LifeState result;
+  for (unsigned i = 0; i < width; i++)
+    result[torus_wrap(column + i)] = state[torus_wrap(column + i)];
+  return result;
+}
+
+TEST(LifeStripTest, LoadStoreWraps) {
+  PRNG::Xoshiro256x4 generator(5);
+  LifeState state = LifeState::RandomState(generator, 0.5);
+
+  for (unsigned column : {0u, 30u, 61u, 63u}) {
+    LifeStateStrip<4> strip(state, {column});
+    LifeState stored;
+    strip.Store(stored, {column});
+    EXPECT_EQ(stored, Isolated(state, column, 4)) << column;
+  }
+}
+
+TEST(LifeStripTest, StepMatchesLifeState) {
+  PRNG::Xoshiro256x4 generator(6);
+  for (unsigned column : {0u, 20u, 60u}) {
+    LifeState state = Isolated(LifeState::RandomState(generator, 0.4), column, 8);
+
+    LifeStateStrip<8> strip(state, {column});
+    LifeState stepped = state;
+    for (unsigned gen = 0; gen < 3; gen++) {
+      strip.Step();
+      stepped = Isolated(stepped.Stepped(), column, 8);
+      LifeState stored;
+      strip.Store(stored, {column});
+      EXPECT_EQ(stored, stepped) << column << " " << gen;
+    }
+  }
+}
+
+TEST(LifeStripTest, CountsMatchLifeState) {
+  PRNG::Xoshiro256x4 generator(7);
+  LifeState state = Isolated(LifeState::RandomState(generator, 0.5), 62, 4);
+
+  LifeState bit3, bit2, bit1, bit0;
+  state.CountNeighbourhood(bit3, bit2, bit1, bit0);
+
+  StripNeighbourCount<4> counts(LifeStateStrip<4>(state, {62}));
+  EXPECT_EQ(counts.bit3, LifeStateStrip<4>(bit3, {62}));
+  EXPECT_EQ(counts.bit2, LifeStateStrip<4>(bit2, {62}));
+  EXPECT_EQ(counts.bit1, LifeStateStrip<4>(bit1, {62}));
+  EXPECT_EQ(counts.bit0, LifeStateStrip<4>(bit0, {62}));
+}
+
+TEST(LifeStripTest, IteratorCoversMask) {
+  for (uint64_t mask : {0x0ULL, 0x1ULL, 0x8000000000000001ULL, 0xF0F0F0F00000FFFFULL, ~0ULL}) {
+    uint64_t covered = 0;
+    for (auto column : StripIterator<4>(mask))
+      covered |= std::rotl(0xFULL, column.index);
+    EXPECT_EQ(covered & mask, mask);
+  }
+}
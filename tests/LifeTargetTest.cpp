@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+
+#include "../LifeAPI.hpp"
+#include "../LifeTarget.hpp"
+#include "../Parsing.hpp"
+
+TEST(LifeTargetTest, MatcherFollowsMatch) {
+  LifeTarget block(LifeState::ConstantParse("2o$2o!"));
+  PRNG::Xoshiro256x4 generator(9);
+
+  for (unsigned trial = 0; trial < 3; trial++) {
+    // Small enough to hit the rechecking, and a whole board for the
+    // fallback to `Match`
+    LifeState state = LifeState::RandomState(generator, 0.4);
+    if (trial < 2)
+      state &= LifeState::SolidRect(-6, -6, 12, 12);
+
+    TargetMatcher matcher(block, state);
+    EXPECT_EQ(matcher.matches, state.Match(block));
+
+    for (unsigned gen = 0; gen < 60; gen++) {
+      LifeState before = matcher.matches;
+      state.Step();
+      matcher.Update(state);
+
+      LifeState expected = state.Match(block);
+      ASSERT_EQ(matcher.matches, expected) << trial << " " << gen;
+      EXPECT_EQ(matcher.appeared, expected & ~before);
+      EXPECT_EQ(matcher.disappeared, before & ~expected);
+    }
+  }
+}
@@ -32,3 +32,147 @@ TEST(LifeWeldTest, RequiredTest) {
     EXPECT_EQ(weld, copy);
   }
 }
+
+TEST(LifeWeldTest, UnweldableMaskThreads) {
+  LifeWeld eater = LifeWeld::FromRequired(
+      LifeState::ConstantParse("2b2o$bobo$bo$2o!"),
+      LifeState::ConstantParse("2b2o$b3o$b4o$5o$4o$4o!").Moved(-1, -1));
+
+  // Only test offsets near the origin
+  LifeState good = ~LifeState::SolidRect(-8, -8, 17, 17);
+
+  // Far more time than any of these needs, so no offset times out and the
+  // answers don't depend on how busy the machine is
+  const float timeout = 10;
+
+  LifeState serial = eater.UnweldableMask(eater, good, LifeState(), 1, nullptr, timeout);
+  LifeState parallel = eater.UnweldableMask(eater, good, LifeState(), 4, nullptr, timeout);
+  EXPECT_EQ(serial, parallel);
+
+  WeldCache cache;
+  LifeState first = eater.UnweldableMask(eater, good, LifeState(), 4, &cache, timeout);
+  EXPECT_FALSE(cache.unweldable.empty());
+  LifeState second = eater.UnweldableMask(eater, good, LifeState(), 4, &cache, timeout);
+  EXPECT_EQ(first, serial);
+  EXPECT_EQ(second, serial);
+
+  for (auto cell : (serial & ~eater.InteractionOffsets(eater) & ~good).OnCells())
+    EXPECT_TRUE(eater.Unweldable(eater, cell, timeout));
+}
+
+TEST(LifeWeldTest, UnweldableMaskSkipsTimeouts) {
+  LifeWeld eater = LifeWeld::FromRequired(
+      LifeState::ConstantParse("2b2o$bobo$bo$2o!"),
+      LifeState::ConstantParse("2b2o$b3o$b4o$5o$4o$4o!").Moved(-1, -1));
+  LifeState good = ~LifeState::SolidRect(-8, -8, 17, 17);
+
+  // No time at all for the full completion, so only offsets the
+  // propagation settles can be cached
+  WeldCache cache;
+  eater.UnweldableMask(eater, good, LifeState(), 1, &cache, 0);
+  for (auto &[key, unweldable] : cache.unweldable)
+    EXPECT_EQ(unweldable, eater.Unweldable(eater, key.offset, 10));
+
+  LifeState settled;
+  for (auto &[key, unweldable] : cache.unweldable)
+    settled.Set(key.offset);
+  LifeState expected = eater.UnweldableMask(eater, good, LifeState(), 1, nullptr, 10);
+  EXPECT_EQ(eater.UnweldableMask(eater, good, LifeState(), 1, &cache, 10), expected);
+  EXPECT_GT(cache.unweldable.size(), settled.GetPop());
+}
+
+LifeState ReferenceWeldStep(const LifeWeld &weld) {
+  LifeState bit3, bit2, bit1, bit0;
+  weld.state.CountNeighbourhood(bit3, bit2, bit1, bit0);
+
+  LifeState sum2, sum1, sum0, carry2, carry1, carry0;
+  LifeState::HalfAdd(sum0, carry0, bit0, weld.frozen0);
+  LifeState::FullAdd(sum1, carry1, bit1, weld.frozen1, carry0);
+  LifeState::FullAdd(sum2, carry2, bit2, weld.frozen2, carry1);
+
+  return (sum0 ^ sum2) & (sum1 ^ sum2) & (weld.state | sum0);
+}
+
+TEST(LifeWeldTest, StepRandom) {
+  for (unsigned i = 0; i < 1000; i++) {
+    LifeState frozen = LifeState::RandomState() & LifeState::RandomState();
+    LifeWeld weld(LifeState::RandomState() & ~frozen,
+                  frozen & LifeState::RandomState(),
+                  frozen & LifeState::RandomState(),
+                  frozen & LifeState::RandomState());
+
+    LifeState expected = ReferenceWeldStep(weld);
+    weld.Step();
+    EXPECT_EQ(weld.state, expected);
+  }
+}
+
+TEST(LifeWeldTest, StepManyStopsWhenStill) {
+  LifeWeld weld(LifeState::ConstantParse("2o$obo$2bo$2b2o!"));
+  LifeWeld blinker(LifeState::ConstantParse("3o!").Moved(20, 20));
+
+  EXPECT_EQ(weld.Stepped(100), weld);
+  EXPECT_EQ((weld | blinker).Stepped(101), weld | blinker.Stepped());
+}
+
+// The original two-replay implementation, with the stay-dead rules for a
+// stator count of 3 and for (0, 1) that it was missing
+LifeStable ReferenceToStable(const LifeWeld &weld, const LifeState &active, unsigned duration, const LifeState &mask) {
+  LifeStable stable = weld.ToStable();
+
+  LifeState everActive;
+  LifeWeld current = weld;
+  current.state |= active;
+  for (unsigned i = 0; i < duration; i++) {
+    everActive |= weld.state ^ current.state;
+    current.Step();
+  }
+  stable.SetOff(mask & ~weld.state & everActive);
+
+  NeighbourCount stateCounts(weld.state);
+  current = weld;
+  current.state |= active;
+
+  struct Rule { unsigned current; unsigned state; StableOptions options; };
+  const std::vector<Rule> bornRules = {
+    {3, 0, StableOptions::DEAD0}, {3, 1, StableOptions::DEAD1}, {3, 2, StableOptions::DEAD2},
+  };
+  const std::vector<Rule> stayRules = {
+    {1, 0, ~StableOptions::DEAD2}, {2, 0, ~StableOptions::DEAD1}, {2, 1, ~StableOptions::DEAD2},
+    {1, 2, ~StableOptions::DEAD4}, {0, 2, ~StableOptions::DEAD5}, {3, 4, ~StableOptions::DEAD4},
+    {2, 4, ~StableOptions::DEAD5}, {1, 4, ~StableOptions::DEAD6}, {3, 5, ~StableOptions::DEAD5},
+    {2, 5, ~StableOptions::DEAD6}, {3, 6, ~StableOptions::DEAD6},
+    {0, 1, ~StableOptions::DEAD4}, {2, 3, ~StableOptions::DEAD4}, {1, 3, ~StableOptions::DEAD5},
+    {0, 3, ~StableOptions::DEAD6},
+  };
+
+  for (unsigned i = 0; i < duration; i++) {
+    LifeWeld next = current.Stepped();
+    LifeState stayDead = ~weld.state & ~current.state & ~next.state;
+    LifeState getsBorn = ~weld.state & ~current.state &  next.state;
+    NeighbourCount currentCounts(current.state);
+
+    for (auto &r : bornRules)
+      stable.RestrictOptions(mask & getsBorn & currentCounts.WithExactly(r.current) & stateCounts.WithExactly(r.state), r.options);
+    for (auto &r : stayRules)
+      stable.RestrictOptions(mask & stayDead & currentCounts.WithExactly(r.current) & stateCounts.WithExactly(r.state), r.options);
+
+    current = next;
+  }
+  return stable;
+}
+
+TEST(LifeWeldTest, ToStableActiveRandom) {
+  LifeWeld eater = LifeWeld::FromRequired(
+      LifeState::ConstantParse("2b2o$bobo$bo$2o!"),
+      LifeState::ConstantParse("2b2o$b3o$b4o$5o$4o$4o!").Moved(-1, -1));
+  LifeState area = LifeState::SolidRect(-6, -6, 8, 8);
+
+  for (unsigned i = 0; i < 100; i++) {
+    LifeState active = area & ~eater.state.ZOI() & LifeState::RandomState() & LifeState::RandomState();
+    LifeState mask = i % 2 == 0 ? ~LifeState() : LifeState::RandomState();
+    unsigned duration = 1 + i % 20;
+
+    EXPECT_EQ(eater.ToStable(active, duration, mask), ReferenceToStable(eater, active, duration, mask));
+  }
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include "../LifeAPI.hpp"
+#include "../Parsing.hpp"
+#include "../NeighbourCount.hpp"
+
+unsigned CountAt(const NeighbourCount &counts, unsigned x, unsigned y) {
+  return counts.bit3.Get(x, y) << 3 | counts.bit2.Get(x, y) << 2 |
+         counts.bit1.Get(x, y) << 1 | counts.bit0.Get(x, y);
+}
+
+TEST(NeighbourCountTest, ClassesMatchWithExactly) {
+  PRNG::Xoshiro256x4 generator(11);
+  for (double density : {0.1, 0.5, 0.9}) {
+    NeighbourCount counts(LifeState::RandomState(generator, density));
+    NeighbourClasses classes = counts.Classes();
+
+    LifeState seen;
+    for (unsigned n = 0; n < NeighbourClasses::count; n++) {
+      EXPECT_EQ(classes[n], counts.WithExactly(n)) << n;
+      EXPECT_TRUE((seen & classes[n]).IsEmpty());
+      seen |= classes[n];
+    }
+    EXPECT_EQ(seen, ~LifeState());
+
+    NeighbourClasses some = counts.Classes<1 << 3 | 1 << 9>();
+    EXPECT_EQ(some[3], classes[3]);
+    EXPECT_EQ(some[9], classes[9]);
+  }
+}
+
+TEST(NeighbourCountTest, SubtractClamped) {
+  PRNG::Xoshiro256x4 generator(12);
+  NeighbourCount a(LifeState::RandomState(generator, 0.5));
+  NeighbourCount b(LifeState::RandomState(generator, 0.5));
+  NeighbourCount difference = a.SubtractClamped(b);
+
+  for (unsigned x = 0; x < N; x++) {
+    for (unsigned y = 0; y < N; y++) {
+      unsigned expected = std::max((int)CountAt(a, x, y) - (int)CountAt(b, x, y), 0);
+      EXPECT_EQ(CountAt(difference, x, y), expected);
+    }
+  }
+}
+
+TEST(NeighbourCountTest, UpdateMatchesRecount) {
+  PRNG::Xoshiro256x4 generator(13);
+  LifeState state = LifeState::RandomState(generator, 0.3);
+  NeighbourCount counts(state);
+
+  // A few cells at a time, including across the seam at column 0, then
+  // enough at once to fall back to a full count
+  for (unsigned flips : {1, 3, 8, 40}) {
+    LifeState changed;
+    for (unsigned i = 0; i < flips; i++)
+      changed.Set(generator() % N, generator() % N);
+    changed.Set(0, 5);
+    changed.Set(N - 1, 5);
+    state ^= changed;
+    counts.Update(state, changed);
+
+    NeighbourCount expected(state);
+    EXPECT_EQ(counts.bit3, expected.bit3) << flips;
+    EXPECT_EQ(counts.bit2, expected.bit2) << flips;
+    EXPECT_EQ(counts.bit1, expected.bit1) << flips;
+    EXPECT_EQ(counts.bit0, expected.bit0) << flips;
+  }
+}
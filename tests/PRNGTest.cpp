@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "../LifeAPI.hpp"
+#include "../Parsing.hpp"
+
+TEST(PRNGTest, SplitMix64) {
+  uint64_t state = 1234567;
+  EXPECT_EQ(PRNG::SplitMix64(state), 6457827717110365317ULL);
+  EXPECT_EQ(PRNG::SplitMix64(state), 3203168211198807973ULL);
+  EXPECT_EQ(PRNG::SplitMix64(state), 9817491932198370423ULL);
+}
+
+TEST(PRNGTest, Reproducible) {
+  PRNG::Xoshiro256x4 a(42), b(42), c(43);
+  EXPECT_EQ(LifeState::RandomState(a), LifeState::RandomState(b));
+  EXPECT_NE(LifeState::RandomState(a), LifeState::RandomState(c));
+
+  // The buffered single outputs are the same stream as `Fill`
+  PRNG::Xoshiro256x4 filled(42), single(42);
+  uint64_t words[8];
+  filled.Fill(words, 8);
+  for (unsigned i = 0; i < 8; i++)
+    EXPECT_EQ(single(), words[i]);
+
+  // Also when the counts aren't whole blocks, and without writing past
+  // the end
+  uint64_t partial[7];
+  for (unsigned count : {1u, 6u, 3u, 5u}) {
+    partial[count] = 0;
+    filled.Fill(partial, count);
+    for (unsigned i = 0; i < count; i++)
+      EXPECT_EQ(single(), partial[i]) << count;
+    EXPECT_EQ(partial[count], 0u) << count;
+  }
+
+  PRNG::Xoshiro256 scalar(42), scalarAgain(42);
+  EXPECT_EQ(LifeState::RandomState(scalar), LifeState::RandomState(scalarAgain));
+}
+
+TEST(PRNGTest, ThreadGenerator) {
+  PRNG::Seed(7);
+  LifeState first = LifeState::RandomState();
+
+  // Another thread using its own generator doesn't disturb this one
+  PRNG::Seed(7);
+  std::thread other([]() {
+    PRNG::Seed(7);
+    LifeState::RandomState();
+  });
+  other.join();
+
+  EXPECT_EQ(LifeState::RandomState(), first);
+
+  PRNG::Xoshiro256x4 generator(7);
+  EXPECT_EQ(LifeState::RandomState(generator), first);
+}
+
+TEST(PRNGTest, Density) {
+  PRNG::Xoshiro256x4 generator(1);
+  EXPECT_TRUE(LifeState::RandomState(generator, 0).IsEmpty());
+  EXPECT_EQ(LifeState::RandomState(generator, 1), ~LifeState());
+
+  for (double density : {0.5, 0.25, 0.1, 0.9}) {
+    unsigned pop = 0;
+    for (unsigned i = 0; i < 16; i++)
+      pop += LifeState::RandomState(generator, density).GetPop();
+    double expected = 16 * N * 64 * density;
+    EXPECT_NEAR(pop, expected, 0.05 * expected) << density;
+  }
+}
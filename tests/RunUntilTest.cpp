@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include "../LifeAPI.hpp"
+#include "../Parsing.hpp"
+#include "../RunUntil.hpp"
+
+// The first generation at which `done` holds, by stepping separately
+template <typename F>
+unsigned FirstGeneration(LifeState state, unsigned maxGen, F done) {
+  std::vector<LifeState> generations = {state};
+  for (unsigned gen = 1; gen <= maxGen; gen++) {
+    state.Step();
+    generations.push_back(state);
+    if (done(generations))
+      return gen;
+  }
+  return 0;
+}
+
+TEST(RunUntilTest, MatchesSeparateChecks) {
+  PRNG::Xoshiro256x4 generator(13);
+  LifeState forbidden = LifeState::SolidRect(10, 10, 3, 3);
+  LifeState region = LifeState::SolidRect(-16, -16, 32, 32);
+
+  for (unsigned trial = 0; trial < 10; trial++) {
+    LifeState start = LifeState::RandomState(generator, 0.4) & LifeState::SolidRect(-5, -5, 10, 10);
+    // Found by generation 7 at the latest
+    LifeTarget later(start.Stepped(7), LifeState());
+
+    std::vector<unsigned> expected = {
+        FirstGeneration(start, 200, [](auto &g) { return g.back().GetPop() > 60; }),
+        FirstGeneration(start, 200, [](auto &g) { return g.back().GetPop() < 20; }),
+        FirstGeneration(start, 200, [&](auto &g) { return g.back().Contains(later); }),
+        FirstGeneration(start, 200, [&](auto &g) { return !(g.back() & forbidden).IsEmpty(); }),
+        FirstGeneration(start, 200, [&](auto &g) { return !(g.back() & ~region).IsEmpty(); }),
+        FirstGeneration(start, 200, [](auto &g) { return g.back() == g[g.size() - 2]; }),
+        FirstGeneration(start, 200, [](auto &g) { return g.size() > 3 && g.back() == g[g.size() - 4]; }),
+    };
+
+    auto check = [&](unsigned index, auto &&predicate) {
+      LifeState state = start;
+      RunUntilResult result = RunUntil(state, 200, predicate);
+      if (expected[index] == 0) {
+        EXPECT_FALSE(result.Fired()) << trial << " " << index;
+      } else {
+        EXPECT_EQ(result.predicate, 0) << trial << " " << index;
+        EXPECT_EQ(result.generation, expected[index]) << trial << " " << index;
+        EXPECT_EQ(state, start.Stepped(result.generation));
+      }
+    };
+    check(0, PopulationAbove{60});
+    check(1, PopulationBelow{20});
+    check(2, ContainsTarget{later});
+    check(3, TouchesCells{forbidden});
+    check(4, Escapes{region});
+    check(5, Stabilised<1>{});
+    check(6, Stabilised<3>{});
+
+    // All at once stops at the earliest, preferring the first listed
+    unsigned earliest = 201;
+    int first = -1;
+    for (unsigned i = 0; i < expected.size(); i++) {
+      if (expected[i] != 0 && expected[i] < earliest) {
+        earliest = expected[i];
+        first = i;
+      }
+    }
+    LifeState state = start;
+    RunUntilResult result = RunUntil(state, 200, PopulationAbove{60}, PopulationBelow{20},
+                                     ContainsTarget{later}, TouchesCells{forbidden},
+                                     Escapes{region}, Stabilised<1>{}, Stabilised<3>{});
+    EXPECT_EQ(result.predicate, first) << trial;
+    if (first >= 0) {
+      EXPECT_EQ(result.generation, earliest) << trial;
+    }
+  }
+}
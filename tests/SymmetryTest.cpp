@@ -15,17 +15,17 @@ void TestFundamentalDomain(StaticSymmetry s, std::pair<int, int> offset) {
 
 TEST(SymmetryTest, FundamentalDomainSymmetricizeOrigin) {
   using enum StaticSymmetry;
-  for (auto s : {C1, C2, C4, D2AcrossX, D2AcrossY, D2diagodd, D2negdiagodd, D4, D4diag, }) {
+  for (auto s : {C1, C2, C4, D2AcrossX, D2AcrossY, D2diagodd, D2negdiagodd, D4, D4diag, D8, }) {
     TestFundamentalDomain(s, {0, 0});
   }
 }
 
 TEST(SymmetryTest, FundamentalDomainSymmetricizeOffset) {
   using enum StaticSymmetry;
-  for (auto s : {C1, C2, C4, D4, D4diag, }) {
+  for (auto s : {C1, C2, C4, D4, D4diag, D8, }) {
     for (int i = 1; i < 10; i++) {
       for (int j = 1; j < 10; j++) {
-        if(s == D4diag && (i + j) % 2 == 1)
+        if((s == D4diag || s == D8) && (i + j) % 2 == 1)
           continue;
 
         TestFundamentalDomain(s, {i, j});
@@ -94,3 +94,142 @@ TEST(SymmetryTest, IntersectingOffsets) {
   for (int i = 0; i < 10; i++)
     TestIntersectingOffset(D2negdiagodd, {i, i});
 }
+
+// The copies overlap exactly when the symmetric pattern has fewer cells
+// than all of them would
+void TestIntersectingOffsetsBruteForce(StaticSymmetry s, unsigned copies, bool evenOnly) {
+  PRNG::Xoshiro256x4 generator(8);
+  for (unsigned trial = 0; trial < 4; trial++) {
+    LifeState pattern = LifeState::RandomState(generator, 0.3) & LifeState::SolidRect(trial, -2, 5, 4);
+    LifeState offsets = IntersectingOffsets(pattern, s);
+
+    for (int x = -20; x <= 20; x++) {
+      for (int y = -20; y <= 20; y++) {
+        if (evenOnly && (x + y) % 2 != 0)
+          continue;
+        std::pair<int, int> offset = {torus_wrap(x), torus_wrap(y)};
+        bool overlaps = Symmetricize(pattern, s, offset).GetPop() < copies * pattern.GetPop();
+        EXPECT_EQ(offsets.Get(offset), overlaps)
+            << SymmetryToString(s) << " (" << x << ", " << y << ") " << pattern.RLE();
+      }
+    }
+  }
+}
+
+// Every copy of each cell of `pat1` except itself, unless some other
+// copy lands back on it
+void TestIntersectingOffsetsPairBruteForce(StaticSymmetry s, unsigned copies, bool evenOnly) {
+  PRNG::Xoshiro256x4 generator(9);
+  for (unsigned trial = 0; trial < 4; trial++) {
+    LifeState pat1 = LifeState::RandomState(generator, 0.3) & LifeState::SolidRect(trial, -2, 4, 4);
+    LifeState pat2 = LifeState::RandomState(generator, 0.3) & LifeState::SolidRect(-3, trial, 4, 3);
+    LifeState offsets = IntersectingOffsets(pat1, pat2, s);
+
+    for (int x = -20; x <= 20; x++) {
+      for (int y = -20; y <= 20; y++) {
+        if (evenOnly && (x + y) % 2 != 0)
+          continue;
+        std::pair<int, int> offset = {torus_wrap(x), torus_wrap(y)};
+        LifeState others;
+        for (auto cell : pat1.OnCells()) {
+          LifeState orbit = Symmetricize(LifeState::Cell(cell), s, offset);
+          if (orbit.GetPop() == copies)
+            orbit.Erase(cell);
+          others |= orbit;
+        }
+        EXPECT_EQ(offsets.Get(offset), !(others & pat2).IsEmpty())
+            << SymmetryToString(s) << " (" << x << ", " << y << ") " << pat1.RLE() << " " << pat2.RLE();
+      }
+    }
+  }
+}
+
+TEST(SymmetryTest, IntersectingOffsetsBruteForce) {
+  using enum StaticSymmetry;
+  TestIntersectingOffsetsBruteForce(C2, 2, false);
+  TestIntersectingOffsetsBruteForce(C4, 4, false);
+  TestIntersectingOffsetsBruteForce(D4, 4, false);
+  TestIntersectingOffsetsBruteForce(D4diag, 4, true);
+  TestIntersectingOffsetsBruteForce(D8, 8, true);
+}
+
+TEST(SymmetryTest, IntersectingOffsetsPairBruteForce) {
+  using enum StaticSymmetry;
+  TestIntersectingOffsetsPairBruteForce(C2, 2, false);
+  TestIntersectingOffsetsPairBruteForce(C4, 4, false);
+  TestIntersectingOffsetsPairBruteForce(D4, 4, false);
+  TestIntersectingOffsetsPairBruteForce(D4diag, 4, true);
+  TestIntersectingOffsetsPairBruteForce(D8, 8, true);
+}
+
+TEST(SymmetryTest, OctoHashInvariant) {
+  LifeState block = LifeState::ConstantParse("2o$2o!");
+  LifeState glider = LifeState::ConstantParse("bo$2bo$3o!");
+  EXPECT_NE(block.GetOctoHash(), glider.GetOctoHash());
+  EXPECT_NE(block.GetOctoHash(), LifeState::ConstantParse("3o!").GetOctoHash());
+
+  for (unsigned i = 0; i < 20; i++) {
+    LifeState pattern = LifeState::RandomState() & LifeState::SolidRect(-4, -4, 8, 8);
+    for (auto t : allTransforms)
+      EXPECT_EQ(pattern.Transformed(t).Moved(3, -2).GetOctoHash(), pattern.GetOctoHash());
+  }
+}
+
+TEST(SymmetryTest, OrbitSizes) {
+  using enum StaticSymmetry;
+  EXPECT_EQ(SymmetryGroupFromEnum(C1).size(), 1u);
+  EXPECT_EQ(SymmetryGroupFromEnum(C4).size(), 4u);
+  EXPECT_EQ(SymmetryGroupFromEnum(D8).size(), 8u);
+  EXPECT_EQ(SymmetryChainFromEnum(D8).size(), 3u);
+
+  // Block, blinker, and a pattern with no symmetry at all
+  EXPECT_EQ(LifeState::ConstantParse("2o$2o!").SymmetryOrbit().size(), 1u);
+  EXPECT_EQ(LifeState::ConstantParse("3o!").SymmetryOrbit().size(), 2u);
+  LifeState asymmetric = LifeState::ConstantParse("2o$o$3o!");
+  EXPECT_EQ(asymmetric.SymmetryOrbit().size(), 8u);
+  EXPECT_EQ(asymmetric.SymmetryOrbitRepresentatives().size(), 8u);
+}
+
+TEST(SymmetryTest, CompressExpandBits) {
+  PRNG::Xoshiro256x4 generator(3);
+  LifeState words = LifeState::RandomState(generator, 0.5);
+  LifeState masks = LifeState::RandomState(generator, 0.5);
+
+  for (unsigned i = 0; i < N; i++) {
+    uint64_t x = words[i], m = masks[i];
+    uint64_t compressed = 0, expanded = 0;
+    unsigned k = 0;
+    for (unsigned b = 0; b < 64; b++) {
+      if ((m >> b) & 1) {
+        compressed |= ((x >> b) & 1) << k;
+        expanded |= ((x >> k) & 1) << b;
+        k++;
+      }
+    }
+    EXPECT_EQ(compress_right(x, m), compressed);
+    EXPECT_EQ(expand_right(x, m), expanded);
+    EXPECT_EQ(expand_right(compress_right(x, m), m), x & m);
+
+    uint64_t out;
+    compress_right(&x, &out, 1, m);
+    EXPECT_EQ(out, compressed);
+    expand_right(&x, &out, 1, m);
+    EXPECT_EQ(out, expanded);
+  }
+}
+
+TEST(SymmetryTest, DoubleUndoesHalve) {
+  PRNG::Xoshiro256x4 generator(4);
+  LifeState state = LifeState::RandomState(generator, 0.5);
+
+  LifeState doubled;
+  for (auto [x, y] : state.Cells())
+    doubled.SetSafe(2 * x, 2 * y, true);
+  EXPECT_EQ(state.Double(), doubled);
+
+  LifeState halved = state.Halve();
+  EXPECT_EQ(halved.Double().Halve(), halved);
+  EXPECT_EQ(state.HalveX().DoubleX().HalveX(), state.HalveX());
+  EXPECT_EQ(state.HalveY().DoubleY().HalveY(), state.HalveY());
+  EXPECT_EQ(halved.Double(), state.HalveX().DoubleX().HalveY().DoubleY());
+}